@@ -0,0 +1,208 @@
+/*
+ * C host of libocean_fft: checks the ABI contract and times the two output modes
+ *   ocean_fft_host [resolution] [frames]     returns 0 when every check passes
+ */
+
+#include "ocean_fft.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !defined(_WIN32)
+	#include <pthread.h>
+#endif
+
+static int failures = 0;
+
+#define CHECK(condition) do { if (!(condition)) { printf("  FAILED: %s (line %d)\n", #condition, __LINE__); ++failures; } } while (0)
+
+static float* aligned_map(uint64_t floats)
+{
+	void* p = NULL;
+#if defined(_WIN32)
+	p = _aligned_malloc(floats * sizeof(float), 64);
+#else
+	p = aligned_alloc(64, floats * sizeof(float)); /* N*N*16 bytes: a multiple of 64 */
+#endif
+	return (float*)p;
+}
+
+static void free_map(float* p)
+{
+#if defined(_WIN32)
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+static double now_ms(void)
+{
+	struct timespec t;
+	timespec_get(&t, TIME_UTC);
+	return t.tv_sec * 1e3 + t.tv_nsec * 1e-6;
+}
+
+/* max |a - b| relative to max |a| */
+static double relative_error(const float* a, const float* b, uint64_t floats)
+{
+	double error = 0.0, scale = 0.0;
+	for (uint64_t i = 0; i < floats; ++i) {
+		double const d = fabs((double)a[i] - b[i]);
+		if (d > error) error = d;
+		if (fabs(a[i]) > scale) scale = fabs(a[i]);
+	}
+	return scale > 0.0 ? error / scale : error;
+}
+
+static void check_maps(const float* displacement, const float* normal, uint64_t floats)
+{
+	int finite = 1, foam_range = 1, normal_w = 1;
+	double height = 0.0;
+	for (uint64_t i = 0; i < floats; i += 4) {
+		for (int c = 0; c < 4; ++c)
+			finite &= isfinite(displacement[i + c]) && isfinite(normal[i + c]);
+		foam_range &= displacement[i + 3] >= 0.f && displacement[i + 3] <= 1.f;
+		normal_w &= normal[i + 3] == 1.f;
+		height += fabs(displacement[i + 1]);
+	}
+	CHECK(finite);
+	CHECK(foam_range);
+	CHECK(normal_w);
+	CHECK(height > 0.0);
+}
+
+struct thread_job {
+	ocean_fft* ocean;
+	float* displacement;
+	float* normal;
+	int frames;
+	ocean_fft_status status;
+};
+
+static void* run_job(void* argument)
+{
+	struct thread_job* job = (struct thread_job*)argument;
+	job->status = OCEAN_FFT_OK;
+	for (int f = 0; f < job->frames && job->status == OCEAN_FFT_OK; ++f)
+		job->status = ocean_fft_advance_into(job->ocean, f / 60.0, job->displacement, job->normal);
+	return NULL;
+}
+
+int main(int argc, char** argv)
+{
+	int const resolution = argc > 1 ? atoi(argv[1]) : 256;
+	int const frames = argc > 2 ? atoi(argv[2]) : 60;
+	printf("[ocean_fft host] ABI version %d, %dx%d, %d frames\n", (int)ocean_fft_version(), resolution, resolution, frames);
+	CHECK(ocean_fft_version() == OCEAN_FFT_VERSION);
+
+	ocean_fft_params params;
+	ocean_fft_default_params(&params);
+	params.resolution = resolution;
+
+	/* invalid arguments */
+	ocean_fft* ocean = NULL;
+	ocean_fft_params invalid = params;
+	invalid.resolution = 100;
+	CHECK(ocean_fft_create(&invalid, &ocean) == OCEAN_FFT_INVALID_ARGUMENT && ocean == NULL);
+	invalid = params;
+	invalid.struct_size = 8;
+	CHECK(ocean_fft_create(&invalid, &ocean) == OCEAN_FFT_INVALID_ARGUMENT && ocean == NULL);
+	CHECK(ocean_fft_create(NULL, &ocean) == OCEAN_FFT_INVALID_ARGUMENT);
+	ocean_fft_destroy(NULL);
+
+	CHECK(ocean_fft_create(&params, &ocean) == OCEAN_FFT_OK && ocean != NULL);
+	if (ocean == NULL) return 1;
+	uint64_t const floats = ocean_fft_map_size(ocean);
+	CHECK(floats == (uint64_t)resolution * resolution * 4);
+
+	float* displacement = aligned_map(floats);
+	float* normal = aligned_map(floats);
+	float* copy = aligned_map(floats);
+	CHECK(ocean_fft_advance_into(ocean, 0.0, displacement + 1, normal) == OCEAN_FFT_MISALIGNED);
+	CHECK(ocean_fft_advance_into(ocean, 0.0, displacement, displacement) == OCEAN_FFT_INVALID_ARGUMENT);
+
+	/* caller buffers */
+	CHECK(ocean_fft_advance_into(ocean, 10.0, displacement, normal) == OCEAN_FFT_OK);
+	check_maps(displacement, normal, floats);
+
+	/* internal double buffer: same maps, the previous set stays readable */
+	ocean_fft* buffered = NULL;
+	CHECK(ocean_fft_create(&params, &buffered) == OCEAN_FFT_OK);
+	const float* front_displacement = NULL;
+	const float* front_normal = NULL;
+	CHECK(ocean_fft_advance(buffered, 10.0, &front_displacement, &front_normal) == OCEAN_FFT_OK);
+	CHECK(((uintptr_t)front_displacement % 64) == 0 && ((uintptr_t)front_normal % 64) == 0);
+	CHECK(relative_error(displacement, front_displacement, floats) == 0.0);
+	CHECK(relative_error(normal, front_normal, floats) == 0.0);
+
+	memcpy(copy, front_displacement, floats * sizeof(float));
+	const float* back_displacement = NULL;
+	const float* back_normal = NULL;
+	CHECK(ocean_fft_advance(buffered, 10.5, &back_displacement, &back_normal) == OCEAN_FFT_OK);
+	CHECK(back_displacement != front_displacement);
+	CHECK(memcmp(copy, front_displacement, floats * sizeof(float)) == 0);
+	check_maps(back_displacement, back_normal, floats);
+
+	/* pipelined spectrum: same maps up to the rounding of the phases */
+	ocean_fft_params pipelined = params;
+	pipelined.time_step = 1.0 / 60.0;
+	ocean_fft* ahead = NULL;
+	CHECK(ocean_fft_create(&pipelined, &ahead) == OCEAN_FFT_OK);
+	double error = 0.0;
+	for (int f = 0; f < 4; ++f) {
+		double const t = 10.0 + f * pipelined.time_step;
+		CHECK(ocean_fft_advance(ahead, t, &front_displacement, &front_normal) == OCEAN_FFT_OK);
+		CHECK(ocean_fft_advance_into(ocean, t, displacement, normal) == OCEAN_FFT_OK);
+		double const e = relative_error(displacement, front_displacement, floats);
+		if (e > error) error = e;
+	}
+	printf("  pipelined vs serial: %.2g max relative error\n", error);
+	CHECK(error < 1e-4);
+
+	/* timings of the steady state */
+	double start = now_ms();
+	for (int f = 0; f < frames; ++f)
+		ocean_fft_advance_into(ocean, 20.0 + f / 60.0, displacement, normal);
+	double const into_ms = (now_ms() - start) / frames;
+	start = now_ms();
+	for (int f = 0; f < frames; ++f)
+		ocean_fft_advance(ahead, 20.0 + f * pipelined.time_step, &front_displacement, &front_normal);
+	double const buffered_ms = (now_ms() - start) / frames;
+	printf("  caller buffers: %.3f ms per frame, internal double buffer (pipelined): %.3f ms per frame\n", into_ms, buffered_ms);
+
+#if !defined(_WIN32)
+	/* distinct handles on concurrent threads: same maps as one after the other */
+	{
+		float* maps[4];
+		for (int k = 0; k < 4; ++k) maps[k] = aligned_map(floats);
+		ocean_fft* first = NULL;
+		ocean_fft* second = NULL;
+		CHECK(ocean_fft_create(&params, &first) == OCEAN_FFT_OK);
+		CHECK(ocean_fft_create(&params, &second) == OCEAN_FFT_OK);
+		struct thread_job jobs[2] = { { first, maps[0], maps[1], 10, OCEAN_FFT_OK }, { second, maps[2], maps[3], 10, OCEAN_FFT_OK } };
+		pthread_t threads[2];
+		for (int k = 0; k < 2; ++k) pthread_create(&threads[k], NULL, run_job, &jobs[k]);
+		for (int k = 0; k < 2; ++k) pthread_join(threads[k], NULL);
+		CHECK(jobs[0].status == OCEAN_FFT_OK && jobs[1].status == OCEAN_FFT_OK);
+		CHECK(relative_error(maps[0], maps[2], floats) == 0.0);
+		CHECK(relative_error(maps[1], maps[3], floats) == 0.0);
+		ocean_fft_destroy(second);
+		ocean_fft_destroy(first);
+		for (int k = 0; k < 4; ++k) free_map(maps[k]);
+	}
+#endif
+
+	ocean_fft_destroy(ahead);
+	ocean_fft_destroy(buffered);
+	ocean_fft_destroy(ocean);
+	free_map(copy);
+	free_map(normal);
+	free_map(displacement);
+
+	printf(failures == 0 ? "[ocean_fft host] all checks passed\n" : "[ocean_fft host] %d checks failed\n", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+// Rust host of libocean_fft: hand written bindings of ocean_fft.h, no crate needed
+//   rustc -O library/host.rs -L <build dir> -l ocean_fft -C link-args=-Wl,-rpath,<build dir>
+//   ./host [resolution] [frames]     returns 0 when every check passes
+
+use std::os::raw::c_int;
+
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct OceanFftParams {
+	struct_size: u32,
+	resolution: i32,
+	ocean_size: i32,
+	amplitude: f32,
+	wind_x: f32,
+	wind_z: f32,
+	choppiness: f32,
+	seed: u32,
+	num_threads: i32,
+	time_step: f64,
+	foam: i32,
+	foam_threshold: f32,
+	foam_lifetime: f32,
+}
+
+#[repr(C)]
+struct OceanFft {
+	_opaque: [u8; 0],
+}
+
+const OCEAN_FFT_OK: c_int = 0;
+const OCEAN_FFT_VERSION: i32 = 1;
+
+extern "C" {
+	fn ocean_fft_version() -> i32;
+	fn ocean_fft_default_params(params: *mut OceanFftParams);
+	fn ocean_fft_create(params: *const OceanFftParams, ocean: *mut *mut OceanFft) -> c_int;
+	fn ocean_fft_destroy(ocean: *mut OceanFft);
+	fn ocean_fft_advance_into(ocean: *mut OceanFft, time: f64, displacement: *mut f32, normal: *mut f32) -> c_int;
+	fn ocean_fft_advance(ocean: *mut OceanFft, time: f64, displacement: *mut *const f32, normal: *mut *const f32) -> c_int;
+	fn ocean_fft_map_size(ocean: *const OceanFft) -> u64;
+}
+
+// One RGBA texel, aligned as the library requires for caller buffers (OCEAN_FFT_ALIGNMENT)
+#[repr(C, align(16))]
+#[derive(Clone, Copy, PartialEq)]
+struct Texel([f32; 4]);
+
+// Owns a handle: not Sync (calls must not overlap), but Send (any thread, one at a time)
+struct Ocean(*mut OceanFft);
+unsafe impl Send for Ocean {}
+
+impl Ocean {
+	fn new(params: &OceanFftParams) -> Option<Ocean> {
+		let mut ocean = std::ptr::null_mut();
+		let status = unsafe { ocean_fft_create(params, &mut ocean) };
+		if status == OCEAN_FFT_OK { Some(Ocean(ocean)) } else { None }
+	}
+
+	fn map_size(&self) -> usize {
+		unsafe { ocean_fft_map_size(self.0) as usize }
+	}
+
+	// Caller-owned maps
+	fn advance_into(&mut self, time: f64, displacement: &mut [Texel], normal: &mut [Texel]) -> bool {
+		assert!(displacement.len() * 4 == self.map_size() && normal.len() * 4 == self.map_size());
+		unsafe { ocean_fft_advance_into(self.0, time, displacement.as_mut_ptr() as *mut f32, normal.as_mut_ptr() as *mut f32) == OCEAN_FFT_OK }
+	}
+
+	// Internal double buffer: the slices borrow the handle mutably, so they cannot outlive the next advance call
+	fn advance(&mut self, time: f64) -> Option<(&[f32], &[f32])> {
+		let mut displacement = std::ptr::null();
+		let mut normal = std::ptr::null();
+		let size = self.map_size();
+		unsafe {
+			if ocean_fft_advance(self.0, time, &mut displacement, &mut normal) != OCEAN_FFT_OK {
+				return None;
+			}
+			Some((std::slice::from_raw_parts(displacement, size), std::slice::from_raw_parts(normal, size)))
+		}
+	}
+}
+
+impl Drop for Ocean {
+	fn drop(&mut self) {
+		unsafe { ocean_fft_destroy(self.0) }
+	}
+}
+
+fn main() {
+	let arguments: Vec<String> = std::env::args().collect();
+	let resolution: i32 = arguments.get(1).and_then(|a| a.parse().ok()).unwrap_or(256);
+	let frames: usize = arguments.get(2).and_then(|a| a.parse().ok()).unwrap_or(60);
+	let mut failures = 0;
+	let mut check = |condition: bool, what: &str| {
+		if !condition {
+			println!("  FAILED: {}", what);
+			failures += 1;
+		}
+	};
+
+	let version = unsafe { ocean_fft_version() };
+	println!("[ocean_fft rust host] ABI version {}, {}x{}, {} frames", version, resolution, resolution, frames);
+	check(version == OCEAN_FFT_VERSION, "ABI version");
+
+	let mut params: OceanFftParams = unsafe { std::mem::zeroed() };
+	unsafe { ocean_fft_default_params(&mut params) };
+	check(params.struct_size as usize == std::mem::size_of::<OceanFftParams>(), "struct layout");
+	params.resolution = resolution;
+
+	let mut caller = Ocean::new(&params).expect("ocean_fft_create");
+	let texels = caller.map_size() / 4;
+	let mut displacement = vec![Texel([0f32; 4]); texels];
+	let mut normal = vec![Texel([0f32; 4]); texels];
+	check(caller.advance_into(10.0, &mut displacement, &mut normal), "advance_into");
+	check(displacement.iter().all(|d| d.0.iter().all(|v| v.is_finite()) && d.0[3] >= 0.0 && d.0[3] <= 1.0), "finite maps, foam in [0, 1]");
+	check(normal.iter().all(|n| n.0[3] == 1.0), "normal w");
+
+	// same maps through the internal double buffer
+	let mut buffered = Ocean::new(&params).expect("ocean_fft_create");
+	let same = match buffered.advance(10.0) {
+		Some((d, n)) => d.chunks(4).zip(displacement.iter()).all(|(a, b)| a == b.0) && n.chunks(4).zip(normal.iter()).all(|(a, b)| a == b.0),
+		None => false,
+	};
+	check(same, "caller buffers and internal double buffer give the same maps");
+
+	// distinct handles on their own threads
+	let workers: Vec<_> = (0..2)
+		.map(|_| {
+			let mut ocean = Ocean::new(&params).expect("ocean_fft_create");
+			std::thread::spawn(move || {
+				let mut d = vec![Texel([0f32; 4]); texels];
+				let mut n = vec![Texel([0f32; 4]); texels];
+				for f in 0..frames {
+					assert!(ocean.advance_into(f as f64 / 60.0, &mut d, &mut n));
+				}
+				d
+			})
+		})
+		.collect();
+	let results: Vec<_> = workers.into_iter().map(|w| w.join().unwrap()).collect();
+	check(results[0] == results[1], "concurrent handles give the same maps");
+
+	let start = std::time::Instant::now();
+	for f in 0..frames {
+		buffered.advance(20.0 + f as f64 / 60.0);
+	}
+	println!("  internal double buffer: {:.3} ms per frame", start.elapsed().as_secs_f64() * 1e3 / frames as f64);
+
+	if failures == 0 {
+		println!("[ocean_fft rust host] all checks passed");
+	} else {
+		println!("[ocean_fft rust host] {} checks failed", failures);
+		std::process::exit(1);
+	}
+}
@@ -0,0 +1,189 @@
+#include "ocean_fft.h"
+
+#include "ocean_cpu.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Internal buffer set of ocean_fft_advance, aligned on a cache line
+struct ocean_fft_maps {
+	std::vector<float> storage;
+	float* displacement = nullptr;
+	float* normal = nullptr;
+
+	void allocate(size_t floats)
+	{
+		size_t const line = 64 / sizeof(float);
+		size_t const stride = (floats + line - 1) / line * line;
+		storage.assign(2 * stride + line, 0.f);
+		uintptr_t const address = reinterpret_cast<uintptr_t>(storage.data());
+		displacement = storage.data() + (line - (address / sizeof(float)) % line) % line;
+		normal = displacement + stride;
+	}
+};
+
+struct ocean_fft {
+	ocean_cpu_structure engine;
+	ocean_fft_params params;
+
+	ocean_fft_maps maps[2];
+	int back = 0;                         // buffer set written by the next ocean_fft_advance
+	bool maps_valid = false;              // maps[1 - back] holds the previous maps (accumulated foam)
+	float const* last_target = nullptr;   // displacement written by the last ocean_fft_advance_into
+};
+
+static bool is_power_of_two(int32_t n) { return n > 0 && (n & (n - 1)) == 0; }
+
+int32_t ocean_fft_version(void)
+{
+	return OCEAN_FFT_VERSION;
+}
+
+void ocean_fft_default_params(ocean_fft_params* params)
+{
+	if (params == nullptr) return;
+	// same ocean as the demo
+	params->struct_size = sizeof(ocean_fft_params);
+	params->resolution = 256;
+	params->ocean_size = 512;
+	params->amplitude = 40.f;
+	params->wind_x = 28.28f;
+	params->wind_z = 28.28f;
+	params->choppiness = 1.5f;
+	params->seed = 1;
+	params->num_threads = 0;
+	params->time_step = 0.0;
+	params->foam = 1;
+	params->foam_threshold = 0.6f;
+	params->foam_lifetime = 2.f;
+}
+
+ocean_fft_status ocean_fft_create(const ocean_fft_params* params, ocean_fft** ocean)
+{
+	if (ocean == nullptr) return OCEAN_FFT_INVALID_ARGUMENT;
+	*ocean = nullptr;
+	if (params == nullptr || params->struct_size != sizeof(ocean_fft_params)) return OCEAN_FFT_INVALID_ARGUMENT;
+	if (!is_power_of_two(params->resolution) || params->resolution < 16 || params->resolution > 8192) return OCEAN_FFT_INVALID_ARGUMENT;
+	if (params->ocean_size <= 0 || params->num_threads < 0 || params->time_step < 0.0) return OCEAN_FFT_INVALID_ARGUMENT;
+
+	try {
+		std::unique_ptr<ocean_fft> created(new ocean_fft());
+		created->params = *params;
+
+		ocean_cpu_parameters parameters;
+		parameters.resolution = params->resolution;
+		parameters.ocean_size = params->ocean_size;
+		parameters.amplitude = params->amplitude;
+		parameters.wind_x = params->wind_x;
+		parameters.wind_z = params->wind_z;
+		parameters.seed = params->seed;
+
+		ocean_cpu_structure& engine = created->engine;
+		engine.pipelined = params->time_step > 0.0;
+		engine.initialize(parameters, params->num_threads);
+
+		// maps span ocean_size units once divided by N^2
+		float const N = float(params->resolution);
+		engine.foam.jacobian_scale = params->foam ? 1.f / (N * N) : 0.f;
+		engine.foam.threshold = params->foam_threshold;
+		engine.foam.lifetime = params->foam_lifetime;
+
+		size_t const floats = size_t(ocean_fft_map_size(created.get()));
+		created->maps[0].allocate(floats);
+		created->maps[1].allocate(floats);
+
+		// the engine's own maps are never written: targets are always set
+		engine.displacement = std::vector<float>();
+		engine.normal = std::vector<float>();
+
+		*ocean = created.release();
+		return OCEAN_FFT_OK;
+	}
+	catch (std::bad_alloc const&) {
+		return OCEAN_FFT_OUT_OF_MEMORY;
+	}
+	catch (...) {
+		return OCEAN_FFT_INTERNAL_ERROR;
+	}
+}
+
+void ocean_fft_destroy(ocean_fft* ocean)
+{
+	delete ocean; // joins the worker threads
+}
+
+static ocean_fft_status advance(ocean_fft* ocean, double time, ocean_cpu_targets const& targets)
+{
+	ocean_cpu_structure& engine = ocean->engine;
+	engine.targets = targets; // no `previous`: no foam to carry over, whatever the engine's decay
+
+	double const step = ocean->params.time_step;
+	try {
+		engine.update(time, ocean->params.choppiness, step > 0.0 ? time + step : -1.0);
+	}
+	catch (...) {
+		engine.targets = ocean_cpu_targets();
+		return OCEAN_FFT_INTERNAL_ERROR;
+	}
+	engine.targets = ocean_cpu_targets();
+	return OCEAN_FFT_OK;
+}
+
+ocean_fft_status ocean_fft_advance_into(ocean_fft* ocean, double time, float* displacement, float* normal)
+{
+	if (ocean == nullptr || displacement == nullptr || normal == nullptr || displacement == normal) return OCEAN_FFT_INVALID_ARGUMENT;
+	if (reinterpret_cast<uintptr_t>(displacement) % OCEAN_FFT_ALIGNMENT != 0 || reinterpret_cast<uintptr_t>(normal) % OCEAN_FFT_ALIGNMENT != 0)
+		return OCEAN_FFT_MISALIGNED;
+
+	ocean_cpu_targets targets;
+	targets.displacement = displacement;
+	targets.normal = normal;
+	targets.previous = displacement == ocean->last_target ? displacement : nullptr;
+
+	ocean_fft_status const status = advance(ocean, time, targets);
+	ocean->last_target = status == OCEAN_FFT_OK ? displacement : nullptr;
+	ocean->maps_valid = false; // the internal maps no longer hold the latest foam
+	return status;
+}
+
+ocean_fft_status ocean_fft_advance(ocean_fft* ocean, double time, const float** displacement, const float** normal)
+{
+	if (ocean == nullptr || displacement == nullptr || normal == nullptr) return OCEAN_FFT_INVALID_ARGUMENT;
+
+	// the front set is still readable by the host: write the other one, foam carried over from the front set
+	ocean_fft_maps& maps = ocean->maps[ocean->back];
+	ocean_cpu_targets targets;
+	targets.displacement = maps.displacement;
+	targets.normal = maps.normal;
+	targets.previous = ocean->maps_valid ? ocean->maps[1 - ocean->back].displacement : nullptr;
+
+	ocean_fft_status const status = advance(ocean, time, targets);
+	ocean->last_target = nullptr;
+	if (status != OCEAN_FFT_OK) {
+		ocean->maps_valid = false;
+		return status;
+	}
+	*displacement = maps.displacement;
+	*normal = maps.normal;
+	ocean->maps_valid = true;
+	ocean->back = 1 - ocean->back;
+	return OCEAN_FFT_OK;
+}
+
+int32_t ocean_fft_resolution(const ocean_fft* ocean)
+{
+	return ocean != nullptr ? ocean->params.resolution : 0;
+}
+
+uint64_t ocean_fft_map_size(const ocean_fft* ocean)
+{
+	uint64_t const N = uint64_t(ocean_fft_resolution(ocean));
+	return N * N * 4;
+}
+
+double ocean_fft_last_advance_ms(const ocean_fft* ocean)
+{
+	return ocean != nullptr ? ocean->engine.last_update_ms : 0.0;
+}
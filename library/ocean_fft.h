@@ -0,0 +1,95 @@
+#ifndef OCEAN_FFT_H
+#define OCEAN_FFT_H
+
+/*
+ * ocean_fft: the CPU engine of the demo as a shared library with a C ABI (C, C++, Rust through bindgen or a hand written extern block)
+ *
+ * Maps: N x N texels, row-major, 4 floats per texel, unnormalized like the maps of the demo (divide by N^2):
+ *   displacement (Dx, h, Dz, foam)   horizontal displacement, height, foam coverage in [0, 1] (not scaled)
+ *   normal       (nx, 0, nz, 1)      slope: the normal is normalize(-nx / N^2, 1, -nz / N^2)
+ * The patch covers ocean_size x ocean_size units and tiles seamlessly.
+ *
+ * Outputs are never copied:
+ *   - ocean_fft_advance_into writes into caller-owned buffers (N*N*4 floats each, 16 bytes aligned)
+ *   - ocean_fft_advance writes into one of two internal buffer sets (64 bytes aligned) and returns pointers to it
+ * After the first call, advancing does not allocate (the task graphs and queues of the engine are reused).
+ *
+ * Thread safety:
+ *   - a handle is not thread safe: calls on the same handle must not overlap (one thread at a time, any thread)
+ *   - distinct handles are independent and may be advanced concurrently; each one owns num_threads - 1 worker threads,
+ *     the calling thread is the last worker and an advance call returns once the maps are complete
+ *   - the maps returned by ocean_fft_advance can be read from any thread until the second following advance call on the
+ *     handle (the next one writes the other buffer set), or until ocean_fft_destroy
+ *   - the library has no global state: ocean_fft_create and ocean_fft_destroy can be called concurrently on distinct handles
+ *
+ * No C++ exception crosses the ABI: errors are reported as ocean_fft_status.
+ */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+	#if defined(OCEAN_FFT_BUILD)
+		#define OCEAN_FFT_API __declspec(dllexport)
+	#else
+		#define OCEAN_FFT_API __declspec(dllimport)
+	#endif
+#else
+	#define OCEAN_FFT_API __attribute__((visibility("default")))
+#endif
+
+#define OCEAN_FFT_VERSION 1 /* incremented on any ABI change */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ocean_fft ocean_fft; /* opaque */
+
+typedef enum ocean_fft_status {
+	OCEAN_FFT_OK = 0,
+	OCEAN_FFT_INVALID_ARGUMENT = 1, /* null pointer, resolution not a power of two, unknown struct_size... */
+	OCEAN_FFT_MISALIGNED = 2,       /* caller buffer not aligned on OCEAN_FFT_ALIGNMENT */
+	OCEAN_FFT_OUT_OF_MEMORY = 3,
+	OCEAN_FFT_INTERNAL_ERROR = 4
+} ocean_fft_status;
+
+#define OCEAN_FFT_ALIGNMENT 16 /* bytes, caller buffers (one RGBA texel) */
+
+typedef struct ocean_fft_params {
+	uint32_t struct_size;  /* sizeof(ocean_fft_params): set by ocean_fft_default_params */
+	int32_t resolution;    /* N, power of two in [16, 8192] */
+	int32_t ocean_size;    /* L, patch size in world units */
+	float amplitude;       /* Philips spectrum amplitude */
+	float wind_x, wind_z;  /* wind velocity (m/s) */
+	float choppiness;      /* horizontal displacement scale (0: heights only) */
+	uint32_t seed;         /* same seed and parameters: same ocean, on any host */
+	int32_t num_threads;   /* including the calling thread, 0: hardware concurrency */
+	double time_step;      /* > 0: the spectrum of time + time_step is computed during the transforms of time (steady frame rate) */
+	int32_t foam;          /* 0: no foam (foam channel stays 0) */
+	float foam_threshold;  /* foam where the Jacobian of the horizontal displacement drops below (1: flat water) */
+	float foam_lifetime;   /* decay time of the accumulated foam (s) */
+} ocean_fft_params;
+
+OCEAN_FFT_API int32_t ocean_fft_version(void);
+OCEAN_FFT_API void ocean_fft_default_params(ocean_fft_params* params);
+
+/* *ocean is set to NULL on failure */
+OCEAN_FFT_API ocean_fft_status ocean_fft_create(const ocean_fft_params* params, ocean_fft** ocean);
+OCEAN_FFT_API void ocean_fft_destroy(ocean_fft* ocean); /* NULL: no-op */
+
+/* Maps at `time` (s) written to caller buffers of ocean_fft_map_size floats each (16 bytes aligned, must not overlap)
+ * Foam accumulates in place: it carries over when the same displacement buffer is passed again, and restarts otherwise */
+OCEAN_FFT_API ocean_fft_status ocean_fft_advance_into(ocean_fft* ocean, double time, float* displacement, float* normal);
+
+/* Maps at `time` in the internal double buffer; the pointers stay valid until the second following advance call */
+OCEAN_FFT_API ocean_fft_status ocean_fft_advance(ocean_fft* ocean, double time, const float** displacement, const float** normal);
+
+OCEAN_FFT_API int32_t ocean_fft_resolution(const ocean_fft* ocean);
+OCEAN_FFT_API uint64_t ocean_fft_map_size(const ocean_fft* ocean); /* floats per map: N * N * 4 */
+OCEAN_FFT_API double ocean_fft_last_advance_ms(const ocean_fft* ocean);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
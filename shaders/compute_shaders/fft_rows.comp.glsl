@@ -2,8 +2,9 @@
 
 layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
 
-layout(binding = 0, rgba32f) uniform readonly image2D u_input;
-layout(binding = 1, rgba32f) uniform writeonly image2D u_output;
+// one layer per spectrum field (h, Dx, nx, Dz, nz), all transformed by the same dispatch
+layout(binding = 0, rg32f) uniform readonly image2DArray u_input;
+layout(binding = 1, rg32f) uniform writeonly image2DArray u_output;
 
 // REF: http://wwwa.pikara.ne.jp/okojisan/otfft-en/stockham2.html
 
@@ -25,18 +26,19 @@ void main()
 {
     int row = int(gl_GlobalInvocationID.x);
     int col = int(gl_GlobalInvocationID.y);
+    int layer = int(gl_GlobalInvocationID.z);
     int q = col % u_stride;
     int p = (col - q) / u_stride;
 
-    vec4 a = imageLoad(u_input, ivec2(row, col));
-    vec4 b = imageLoad(u_input, ivec2(row, col + (u_resolution>>1)));
+    vec2 a = imageLoad(u_input, ivec3(row, col, layer)).xy;
+    vec2 b = imageLoad(u_input, ivec3(row, col + (u_resolution>>1), layer)).xy;
     
     vec2 wp = euler(p * 2.f * PI / u_count);
-    vec4 fadd = a + b;
-    vec4 fsub = vec4(prod(a.xy-b.xy, wp), prod(a.zw-b.zw, wp));
+    vec2 fadd = a + b;
+    vec2 fsub = prod(a - b, wp);
     
     p<<=1;
-    imageStore(u_output, ivec2(row, q + u_stride*p), fadd);
-    imageStore(u_output, ivec2(row, q + u_stride*(p+1)), fsub);
+    imageStore(u_output, ivec3(row, q + u_stride*p, layer), vec4(fadd, 0, 0));
+    imageStore(u_output, ivec3(row, q + u_stride*(p+1), layer), vec4(fsub, 0, 0));
 
 }
@@ -4,21 +4,45 @@
 
 layout (local_size_x = WORK_GROUP_DIM, local_size_y = WORK_GROUP_DIM) in;
 
-layout (binding = 0, rgba32f) readonly uniform image2D u_dy_map;
-layout (binding = 1, rgba32f) readonly uniform image2D u_dx_map;
-layout (binding = 2, rgba32f) readonly uniform image2D u_dz_map;
-layout (binding = 3, rgba32f) writeonly uniform image2D u_normal_map;
-layout (binding = 4, rgba32f) writeonly uniform image2D u_displacement_map;
+#define FIELD_H 0
+#define FIELD_DX 1
+#define FIELD_NX 2
+#define FIELD_DZ 3
+#define FIELD_NZ 4
+
+layout (binding = 0, rg32f) readonly uniform image2DArray u_fields; // transformed fields
+layout (binding = 1, rgba32f) uniform image2DArray u_maps; // displacement (w: foam) and normal maps of both keyframes
+
+uniform int u_map_layer; // displacement layer, the normal is the next one
+uniform int u_map_layer_prev; // displacement layer of the previous keyframe (accumulated foam)
+
+// foam: coverage where the Jacobian of the horizontal displacement is below the threshold, see ocean_cpu.hpp
+uniform float u_jacobian_scale; // 0: no foam
+uniform float u_foam_threshold;
+uniform float u_foam_gain;
+uniform float u_foam_decay; // since the previous keyframe
 
 // uniform int u_resolution;
 // uniform int u_ocean_size; 
 
+float load_field(in ivec2 pixel_coord, int field){
+	return imageLoad(u_fields, ivec3(pixel_coord, field)).r;
+}
+
 vec3 load_disp(in ivec2 pixel_coord){
-	return vec3(imageLoad(u_dx_map, pixel_coord).r, imageLoad(u_dy_map, pixel_coord).r, imageLoad(u_dz_map, pixel_coord).r);
+	return vec3(load_field(pixel_coord, FIELD_DX), load_field(pixel_coord, FIELD_H), load_field(pixel_coord, FIELD_DZ));
 }
 
 vec3 load_normal(in ivec2 pixel_coord){
-	return vec3(imageLoad(u_dx_map, pixel_coord).b, imageLoad(u_dy_map, pixel_coord).b, imageLoad(u_dz_map, pixel_coord).b);
+	return vec3(load_field(pixel_coord, FIELD_NX), 0.f, load_field(pixel_coord, FIELD_NZ));
+}
+
+// imaginary parts of the transforms: dDx/dx, dDz/dz, dDx/dz
+float jacobian(in ivec2 pixel_coord){
+	float jxx = u_jacobian_scale * imageLoad(u_fields, ivec3(pixel_coord, FIELD_DX)).g;
+	float jzz = u_jacobian_scale * imageLoad(u_fields, ivec3(pixel_coord, FIELD_DZ)).g;
+	float jxz = u_jacobian_scale * imageLoad(u_fields, ivec3(pixel_coord, FIELD_H)).g;
+	return (1.f + jxx) * (1.f + jzz) - jxz * jxz;
 }
 
 void main()
@@ -41,6 +65,10 @@ void main()
 	// vec3 TB = cross(T,B);
 	// imageStore(u_normal_map, pixel_coord, vec4(normalize(TB), 1.f));
 	
-	imageStore(u_normal_map, pixel_coord, vec4(load_normal(pixel_coord), 1.f));
-	imageStore(u_displacement_map, pixel_coord, vec4(load_disp(pixel_coord), 1.f));
+	float coverage = u_jacobian_scale > 0.f ? clamp((u_foam_threshold - jacobian(pixel_coord)) * u_foam_gain, 0.f, 1.f) : 0.f;
+	float previous = u_foam_decay > 0.f ? imageLoad(u_maps, ivec3(pixel_coord, u_map_layer_prev)).w * u_foam_decay : 0.f; // fresh layers may hold anything
+	float foam = max(coverage, previous);
+
+	imageStore(u_maps, ivec3(pixel_coord, u_map_layer + 1), vec4(load_normal(pixel_coord), 1.f));
+	imageStore(u_maps, ivec3(pixel_coord, u_map_layer), vec4(load_disp(pixel_coord), foam));
 }
\ No newline at end of file
@@ -4,15 +4,16 @@
 
 layout (local_size_x = WORK_GROUP_DIM, local_size_y = WORK_GROUP_DIM) in;
 
-layout (binding = 0, rgba32f) uniform image2D u_input; 
+layout (binding = 0, rg32f) uniform image2DArray u_input; // spectrum fields, the layer u_layer is shown
 layout (binding = 1, rgba32f) uniform image2D u_output; 
 
 uniform int u_resolution;
+uniform int u_layer;
 
 void main(void)
 {
     ivec2 pixel_coord = ivec2(gl_GlobalInvocationID.xy);
-    vec4 img = imageLoad(u_input, pixel_coord); 
+    vec4 img = imageLoad(u_input, ivec3(pixel_coord, u_layer)); 
 
     if(pixel_coord.x < (u_resolution>>1)) pixel_coord.x += u_resolution>>1;
     else pixel_coord.x -= u_resolution>>1;
@@ -4,7 +4,7 @@
 
 layout (local_size_x = WORK_GROUP_DIM, local_size_y = WORK_GROUP_DIM) in;
 
-layout (binding = 0, rgba32f) writeonly uniform image2D u_initial_spectrum; //h_0(k)
+layout (binding = 0, rg32f) writeonly uniform image2D u_initial_spectrum; //h_0(k)
 layout (binding = 1, rgba32f) readonly uniform image2D u_gaussian_noise; 
 
 uniform int u_resolution; // resolution
@@ -65,12 +65,11 @@ void main(void)
     // vec2 E_n = imageLoad(u_gaussian_noise, pixel_coord).ba;
 
     float vp = philips(wave_vector)/sqrt(2.0);
-    float vn = philips(-wave_vector)/sqrt(2.0);
 
+    // conj(h_0(-k)) is read at the opposite texel by spectrum_t
     vec2 h = E_p*vp;
-    vec2 h_est = conj(E_p*vn);
     
-    imageStore(u_initial_spectrum, pixel_coord, vec4(h, h_est));
+    imageStore(u_initial_spectrum, pixel_coord, vec4(h, 0.f, 0.f));
     
 
     // NAN TEST
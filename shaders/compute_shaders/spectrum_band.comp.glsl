@@ -0,0 +1,28 @@
+#version 430 core
+
+#define WORK_GROUP_DIM 16
+
+layout (local_size_x = WORK_GROUP_DIM, local_size_y = WORK_GROUP_DIM) in;
+
+// central band of the time varying spectra, transformed at a lower resolution for the distant tiles (one layer per field)
+layout (binding = 0, rg32f) readonly uniform image2DArray u_fields;
+layout (binding = 1, rg32f) writeonly uniform image2DArray u_band_fields;
+
+uniform int u_resolution;      // N
+uniform int u_band_resolution; // M < N
+
+void main()
+{
+	ivec3 texel = ivec3(gl_GlobalInvocationID);
+
+	// centered wave number of the band texel, then the texel of the same wave vector at full resolution
+	int half_band = u_band_resolution >> 1;
+	ivec2 wave = (texel.xy + half_band) % u_band_resolution - half_band;
+	ivec2 source = (wave + u_resolution) % u_resolution;
+
+	// the Nyquist row/column of the band has no symmetric partner: dropped
+	bool nyquist = wave.x == -half_band || wave.y == -half_band;
+	vec2 value = nyquist ? vec2(0.f) : imageLoad(u_fields, ivec3(source, texel.z)).xy;
+
+	imageStore(u_band_fields, texel, vec4(value, 0.f, 0.f));
+}
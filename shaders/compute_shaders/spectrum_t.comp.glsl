@@ -4,17 +4,22 @@
 
 layout (local_size_x = WORK_GROUP_DIM, local_size_y = WORK_GROUP_DIM) in;
 
-layout (binding = 0, rgba32f) uniform image2D u_initial_spectrum; // h_0(k)
-layout (binding = 1, rgba32f) uniform image2D u_vertical_displacement; // h_t(k)
-layout (binding = 2, rgba32f) uniform image2D u_dx_displacement;
-layout (binding = 3, rgba32f) uniform image2D u_dz_displacement;
+#define FIELD_H 0
+#define FIELD_DX 1
+#define FIELD_NX 2
+#define FIELD_DZ 3
+#define FIELD_NZ 4
+
+layout (binding = 0, rg32f) uniform image2D u_initial_spectrum; // h_0(k)
+layout (binding = 1, rg32f) uniform image2DArray u_fields; // h_t(k), D(k,t), n(k,t): one layer each (+ i k D for the foam, see below)
+layout (binding = 2, rg32f) readonly uniform image2D u_dispersion; // (omega(k), omega(k) * epoch mod 2pi), see dispersion.hpp
 
 uniform int u_resolution;
 uniform int u_ocean_size;
 uniform float u_choppiness;
-uniform float u_time;
+uniform float u_time; // relative to the epoch of u_dispersion (stays small at any uptime)
+uniform int u_foam; // 0: no foam, the derivatives of the Jacobian are not packed
 
-const float g = 9.81; // gravity 
 const float PI = 3.14159265358979323846264; // Life of π
 
 
@@ -29,11 +34,6 @@ vec2 euler(const float x){
     return vec2(cos(x), sin(x));
 }
 
-float omega(float k)
-{
-    return sqrt(g * k);
-}
-
 void main(void)
 {
     ivec2 pixel_coord = ivec2(gl_GlobalInvocationID.xy);
@@ -51,14 +51,15 @@ void main(void)
 
     float k = length(wave_vector);
 
-    float phase = omega(k) * u_time;
+    vec2 dispersion = imageLoad(u_dispersion, pixel_coord).rg;
+    vec2 e = euler(dispersion.y + dispersion.x * u_time);
 
     vec2 h0 = imageLoad(u_initial_spectrum, pixel_coord).rg;
-    ivec2 inv_pixel_coord = (u_resolution - pixel_coord);
+    ivec2 inv_pixel_coord = (u_resolution - pixel_coord) % u_resolution; // wrapped: hermitian spectra, real fields
     vec2 h0_est = conj(imageLoad(u_initial_spectrum, inv_pixel_coord).rg);
     // vec2 h0_est = imageLoad(u_initial_spectrum, pixel_coord).ba;
 
-    vec2 h = prod(h0, euler(phase)) + prod(h0_est, euler(-phase));
+    vec2 h = prod(h0, e) + prod(h0_est, conj(e));
     vec2 nx = prod(vec2(0,1), h) * wave_vector.x;
     vec2 nz = prod(vec2(0,1), h) * wave_vector.y;
      
@@ -69,11 +70,25 @@ void main(void)
     // vec2 Dx = (k == 0) ? vec2(0) : prod(vec2(0,-1), h) * wave_vector.x/k * u_choppiness;
     // vec2 Dz = (k == 0) ? vec2(0) : prod(vec2(0,-1), h) * wave_vector.y/k * u_choppiness;
     
+    // the fields are real: their imaginary parts carry the derivatives of the Jacobian (A + iB, B = i k D)
+    //  h -> dDx/dz, Dx -> dDx/dx, Dz -> dDz/dz
+    //  not on the Nyquist row/column: k has the same sign for k and -k there, B would leak into the real part
+    if (u_foam != 0 && pixel_coord.x != (u_resolution >> 1) && pixel_coord.y != (u_resolution >> 1)) {
+        vec2 Jxz = prod(vec2(0,1), Dx) * wave_vector.y;
+        vec2 Jxx = prod(vec2(0,1), Dx) * wave_vector.x;
+        vec2 Jzz = prod(vec2(0,1), Dz) * wave_vector.y;
+        h += prod(vec2(0,1), Jxz);
+        Dx += prod(vec2(0,1), Jxx);
+        Dz += prod(vec2(0,1), Jzz);
+    }
+
     // imageStore(u_vertical_displacement, pixel_coord, vec4(h, 0.f, 0.f));
     // imageStore(u_dx_displacement, pixel_coord, vec4(Dx, 0.f, 0.f));
     // imageStore(u_dz_displacement, pixel_coord, vec4(Dz,  0.f, 0.f));
-    imageStore(u_vertical_displacement, pixel_coord, vec4(h, 0.f, 0.f));
-    imageStore(u_dx_displacement, pixel_coord, vec4(Dx,nx));
-    imageStore(u_dz_displacement, pixel_coord, vec4(Dz,nz));
+    imageStore(u_fields, ivec3(pixel_coord, FIELD_H), vec4(h, 0.f, 0.f));
+    imageStore(u_fields, ivec3(pixel_coord, FIELD_DX), vec4(Dx, 0.f, 0.f));
+    imageStore(u_fields, ivec3(pixel_coord, FIELD_NX), vec4(nx, 0.f, 0.f));
+    imageStore(u_fields, ivec3(pixel_coord, FIELD_DZ), vec4(Dz, 0.f, 0.f));
+    imageStore(u_fields, ivec3(pixel_coord, FIELD_NZ), vec4(nz, 0.f, 0.f));
 
 }
\ No newline at end of file
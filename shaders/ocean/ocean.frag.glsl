@@ -68,6 +68,12 @@ uniform vec3 u_bg_color;
 
 uniform float u_fog_dmax;
 
+// foam coverage: w of the displacement maps of the last two keyframes (see ocean.vert.glsl)
+uniform sampler2DArray u_maps;
+uniform int u_map_layer;
+uniform int u_map_layer_prev;
+uniform float u_blend;
+
 in float dy;
 
 void main()
@@ -136,6 +142,10 @@ void main()
 	vec3 outter_color = vec3(1);
 	color_object *= mix(inner_color, outter_color, dy/3.0);
 
+	// Foam, sampled per pixel (finer than the low quality mesh)
+	float foam = mix(texture(u_maps, vec3(fragment.uv, u_map_layer_prev)).w, texture(u_maps, vec3(fragment.uv, u_map_layer)).w, u_blend);
+	color_object = mix(color_object, vec3(1.0), foam);
+
 	// Compute the final shaded color using Phong model
 	float Ka = material.phong.ambient*2.5f;
 	float Kd = material.phong.diffuse*0.3f;
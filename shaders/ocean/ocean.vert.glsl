@@ -29,20 +29,31 @@ uniform mat4 modelNormal; // Model without scaling used for the normal. modelNor
 // uniform float lambda = 5.0f;
 // uniform float frequency = 2.0f;
 
-uniform sampler2D u_displacement_map;
-uniform sampler2D u_normal_map;
+// displacement and normal maps of the last two keyframes: (displacement, normal) at u_map_layer and u_map_layer_prev
+uniform sampler2DArray u_maps;
+uniform int u_map_layer;
+uniform int u_map_layer_prev;
 uniform int u_resolution;
 
+// temporal LOD: interpolation factor between the keyframes (1 = last keyframe)
+uniform float u_blend;
+
+vec3 sample_map(int layer)
+{
+	return texture(u_maps, vec3(vertex_uv, layer)).xyz;
+}
+
 // Deformer function for position
 vec3 deformer(vec3 p0)
 {
-	return p0 + vec3(texture(u_displacement_map, vertex_uv).rgb / float(u_resolution * u_resolution));
+	vec3 displacement = mix(sample_map(u_map_layer_prev), sample_map(u_map_layer), u_blend);
+	return p0 + displacement / float(u_resolution * u_resolution);
 }
 
 // Deformer function for the normal
 vec3 deformer_normal()
 {
-	return texture(u_normal_map, vertex_uv).xyz;
+	return mix(sample_map(u_map_layer_prev + 1), sample_map(u_map_layer + 1), u_blend);
 }
 
 out float dy;
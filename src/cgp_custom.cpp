@@ -1,5 +1,18 @@
 #include "cgp_custom.hpp"
 
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace cgp;
 
 // TEXTURE CUSTOM
@@ -14,6 +27,8 @@ static GLenum format_to_data_type(GLint format)
 		return GL_RGBA;
 	case GL_R32F:
 		return GL_RED;
+	case GL_RG32F:
+		return GL_RG;
 	case GL_RGBA32F:
 		return GL_RGBA;
 	default:
@@ -32,6 +47,8 @@ static GLenum format_to_component(GLint format)
 		return GL_FLOAT;
 	case GL_R32F:
 		return GL_FLOAT;
+	case GL_RG32F:
+		return GL_FLOAT;
 	case GL_RGBA32F:
 		return GL_FLOAT;
 
@@ -40,6 +57,24 @@ static GLenum format_to_component(GLint format)
 	}
 	error_cgp("Unreachable");
 }
+static size_t format_to_bytes(GLint format)
+{
+	switch (format)
+	{
+	case GL_RGB8:
+	case GL_RGBA8:
+	case GL_R32F:
+		return 4; // RGB8 is padded by most drivers
+	case GL_RG32F:
+		return 8;
+	case GL_RGB32F:
+		return 12;
+	case GL_RGBA32F:
+		return 16;
+	default:
+		return 0;
+	}
+}
 
 template <typename TYPE>
 static GLuint opengl_initialize_texture_2d_on_gpu(int width, int height, TYPE const* data,
@@ -86,7 +121,135 @@ void opengl_texture_image_structure_custom::initialize_texture_2d_on_gpu(int wid
 
 }
 
+void opengl_texture_image_structure_custom::initialize_texture_2d_array_on_gpu(int width_arg, int height_arg, int layers_arg, GLint format_arg, GLint wrap_s, GLint wrap_t, GLint texture_mag_filter, GLint texture_min_filter)
+{
+	width = width_arg;
+	height = height_arg;
+	layers = layers_arg;
+	format = format_arg;
+	texture_type = GL_TEXTURE_2D_ARRAY;
+	is_view = false;
+
+	// immutable storage: layers can be viewed as 2D textures
+	glGenTextures(1, &id); opengl_check;
+	glBindTexture(GL_TEXTURE_2D_ARRAY, id); opengl_check;
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, format, width, height, layers); opengl_check;
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap_s); opengl_check;
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap_t); opengl_check;
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, texture_mag_filter); opengl_check;
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, texture_min_filter); opengl_check;
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0); opengl_check;
+}
+
+void opengl_texture_image_structure_custom::initialize_texture_view(opengl_texture_image_structure_custom const& array, int layer)
+{
+	width = array.width;
+	height = array.height;
+	layers = 1;
+	format = array.format;
+	texture_type = GL_TEXTURE_2D;
+	is_view = true;
+
+	glGenTextures(1, &id); opengl_check;
+	glTextureView(id, GL_TEXTURE_2D, array.id, format, 0, 1, layer, 1); opengl_check;
+	glBindTexture(GL_TEXTURE_2D, id); opengl_check;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); opengl_check;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); opengl_check;
+	glBindTexture(GL_TEXTURE_2D, 0); opengl_check;
+}
+
+void opengl_texture_image_structure_custom::release()
+{
+	if (id != 0) glDeleteTextures(1, &id);
+	id = 0;
+	width = height = 0;
+	layers = 1;
+}
+
+size_t opengl_texture_image_structure_custom::bytes() const
+{
+	if (id == 0 || is_view) return 0;
+	return size_t(width) * height * layers * format_to_bytes(format);
+}
+
+// GPU TIMER
+void opengl_gpu_timer::begin()
+{
+	if (queries[0] == 0) glGenQueries(num_queries, queries);
+	active = !pending[next];
+	if (active) glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+}
+
+uint64_t opengl_gpu_timer::end()
+{
+	if (!active) return 0;
+	glEndQuery(GL_TIME_ELAPSED);
+	pending[next] = true;
+	issued[next] = ++sections;
+	next = (next + 1) % num_queries;
+	active = false;
+	return sections;
+}
+
+float opengl_gpu_timer::consume(std::vector<gpu_timer_section>* completed)
+{
+	double elapsed = 0.0;
+	uint64_t latest = 0;
+	for (int k = 0; k < num_queries; ++k) {
+		if (!pending[k]) continue;
+		GLint available = 0;
+		glGetQueryObjectiv(queries[k], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) continue;
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(queries[k], GL_QUERY_RESULT, &ns);
+		pending[k] = false;
+		if (completed != nullptr) {
+			gpu_timer_section done;
+			done.section = issued[k];
+			done.ms = float(ns * 1e-6);
+			completed->push_back(done);
+		}
+		if (issued[k] > latest) {
+			latest = issued[k];
+			elapsed = ns * 1e-6;
+		}
+	}
+	return float(elapsed);
+}
+
+void opengl_gpu_timer::release()
+{
+	if (queries[0] != 0) glDeleteQueries(num_queries, queries);
+	for (int k = 0; k < num_queries; ++k) {
+		queries[k] = 0;
+		pending[k] = false;
+	}
+	next = 0;
+	sections = 0;
+	active = false;
+}
+
 // SHADER CUSTOM
+#ifndef GL_COMPLETION_STATUS_KHR // GL_KHR/ARB_parallel_shader_compile
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+std::string opengl_program_cache::directory = "";
+bool opengl_program_cache::enabled = true;
+
+// program started by load() and not yet checked
+struct pending_program {
+	GLuint program_id;
+	std::vector<GLuint> shader_ids;
+	std::string key;
+	std::string description;
+};
+static std::vector<pending_program> pending_programs;
+static int programs_from_cache = 0;
+static bool parallel_compile = false; // the driver compiles on its own threads: completion can be polled
+static std::chrono::steady_clock::time_point loading_start;
+static std::ostringstream loading_log; // printed once in opengl_shader_finish_loading (no flush per shader)
+
 static bool check_compilation(GLuint shader)
 {
 	GLint is_compiled = 0;
@@ -113,9 +276,10 @@ static bool check_compilation(GLuint shader)
 	return true;
 }
 
-static bool compile_shader(const GLenum shader_type, std::string const& shader_str, GLuint& shader_id)
+// Create and compile a shader without waiting for the result (checked in opengl_shader_finish_loading)
+static GLuint start_compile_shader(const GLenum shader_type, std::string const& shader_str)
 {
-	shader_id = glCreateShader(shader_type);
+	GLuint const shader_id = glCreateShader(shader_type);
 	assert_cgp( glIsShader(shader_id), "Error creating shader" );
 
 	char const* const shader_cstring = shader_str.c_str();
@@ -123,62 +287,357 @@ static bool compile_shader(const GLenum shader_type, std::string const& shader_s
 
 	// Compile shader
 	glCompileShader(shader_id);
-
-	bool valid = check_compilation(shader_id);
-	return valid;
-}
-
-// COMPUTE SHADER (only from path)
-    GLuint opengl_load_shader(std::string const& compute_shader_path);
-
-// COMPUTE SHADER (only from path)
-void opengl_shader_structure_custom::load(std::string const& compute_shader_path){
-	id = opengl_load_shader(compute_shader_path);
+	return shader_id;
 }
 
-GLuint opengl_load_shader(std::string const& compute_shader_path){
+static std::string read_shader_file(std::string const& path)
+{
 	// Check the file are accessible
-	if (check_file_exist(compute_shader_path) == 0) {
-		std::cout << "Warning: Cannot read the compute shader at location " << compute_shader_path << std::endl;
+	if (check_file_exist(path) == 0) {
+		std::cout << "Warning: Cannot read the shader at location " << path << std::endl;
 		std::cout << "If this file exists, you may need to adapt the directory from where your program is executed \n" << std::endl;
 	}
 
 	// Stop the program here if the file cannot be accessed
-	assert_file_exist(compute_shader_path);
+	assert_file_exist(path);
+	return read_text_file(path);
+}
 
-	// Read the files
-	std::string compute_shader_text = read_text_file(compute_shader_path);
+// PROGRAM BINARY CACHE
+static bool program_binary_supported()
+{
+#ifdef __EMSCRIPTEN__
+	return false;
+#else
+	GLint num_formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+	return opengl_program_cache::enabled && !opengl_program_cache::directory.empty() && num_formats > 0;
+#endif
+}
 
+// Key of a program: every stage source + the driver identification (a driver update invalidates the cache)
+static std::string program_key(std::vector<std::pair<GLenum, std::string>> const& sources)
+{
+	std::string key;
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION }) {
+		char const* value = reinterpret_cast<char const*>(glGetString(name));
+		key += std::string(value != nullptr ? value : "") + "\n";
+	}
+	for (auto const& source : sources)
+		key += std::to_string(source.first) + "\n" + source.second + "\n";
+	return key;
+}
 
-	// Compile the programs
-	GLuint compute_shader_id   = 0; 
-	bool const compute_shader_valid   = compile_shader(GL_COMPUTE_SHADER  , compute_shader_text  , compute_shader_id);
-	if (compute_shader_valid == false) {
-		std::cout << "===> Failed to compile the Compute Shader [" << compute_shader_path << "]" << std::endl;
-		std::cout << "The error message from the compiler should be listed above. The program will stop." << std::endl;
-		error_cgp("Failed to compile compute shader "+ compute_shader_path);
+// FNV-1a 64 bits
+static std::string program_key_hash(std::string const& key)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (unsigned char c : key) {
+		hash ^= c;
+		hash *= 1099511628211ull;
 	}
+	std::ostringstream s;
+	s << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return s.str();
+}
 
-	assert_cgp_no_msg(glIsShader(compute_shader_id));
+static std::string program_cache_path(std::string const& key)
+{
+	return opengl_program_cache::directory + program_key_hash(key) + ".bin";
+}
 
+// File: [key size][key][binary format][binary]. The full key is compared to rule out hash collisions.
+static bool program_cache_load(GLuint program_id, std::string const& key)
+{
+	std::ifstream file(program_cache_path(key), std::ios::binary);
+	if (!file) return false;
+
+	uint64_t key_size = 0;
+	file.read(reinterpret_cast<char*>(&key_size), sizeof(key_size));
+	if (!file || key_size != key.size()) return false;
+	std::string stored_key(key_size, '\0');
+	file.read(&stored_key[0], key_size);
+	if (!file || stored_key != key) return false;
+
+	GLenum format = 0;
+	file.read(reinterpret_cast<char*>(&format), sizeof(format));
+	std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (binary.empty()) return false;
+
+#ifndef __EMSCRIPTEN__
+	glProgramBinary(program_id, format, binary.data(), GLsizei(binary.size()));
+#endif
+	GLint is_linked = GL_FALSE;
+	glGetProgramiv(program_id, GL_LINK_STATUS, &is_linked);
+	if (is_linked == GL_TRUE) return true;
+	while (glGetError() != GL_NO_ERROR) {} // an unknown format leaves GL_INVALID_ENUM behind
+	return false; // rejected by the driver: compile from source and overwrite
+}
+
+static void program_cache_store(GLuint program_id, std::string const& key)
+{
+#ifndef __EMSCRIPTEN__
+	GLint length = 0;
+	glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program_id, length, nullptr, &format, binary.data());
+
+#ifdef _WIN32
+	_mkdir(opengl_program_cache::directory.c_str());
+#else
+	mkdir(opengl_program_cache::directory.c_str(), 0755);
+#endif
+
+	// write then rename: a concurrent start never reads a partial file
+	std::string const path = program_cache_path(key);
+	std::string const tmp_path = path + ".tmp";
+	{
+		std::ofstream file(tmp_path, std::ios::binary);
+		if (!file) return;
+		uint64_t const key_size = key.size();
+		file.write(reinterpret_cast<char const*>(&key_size), sizeof(key_size));
+		file.write(key.data(), key.size());
+		file.write(reinterpret_cast<char const*>(&format), sizeof(format));
+		file.write(binary.data(), binary.size());
+	}
+	std::remove(path.c_str());
+	std::rename(tmp_path.c_str(), path.c_str());
+#endif
+}
+
+// Let the driver compile on its own threads (GL_KHR/ARB_parallel_shader_compile)
+static void enable_parallel_compile()
+{
+	static bool initialized = false;
+	if (initialized) return;
+	initialized = true;
+
+	typedef void (*max_threads_function)(GLuint);
+	for (auto const& name : { std::string("KHR"), std::string("ARB") }) {
+		if (!glfwExtensionSupported(("GL_" + name + "_parallel_shader_compile").c_str())) continue;
+		auto const max_threads = reinterpret_cast<max_threads_function>(glfwGetProcAddress(("glMaxShaderCompilerThreads" + name).c_str()));
+		if (max_threads != nullptr) {
+			max_threads(0xFFFFFFFF); // implementation-dependent maximum
+			parallel_compile = true;
+			loading_log << "  [info] Parallel shader compilation enabled (GL_" << name << "_parallel_shader_compile)\n";
+			return;
+		}
+	}
+}
+
+// Cached binary if valid, otherwise start compiling and linking (non-blocking when the driver compiles in parallel)
+static GLuint opengl_start_program(std::vector<std::pair<GLenum, std::string>> const& sources, std::string const& description)
+{
+	if (pending_programs.empty() && programs_from_cache == 0)
+		loading_start = std::chrono::steady_clock::now();
+	enable_parallel_compile();
 
-	// Create Program
 	GLuint const program_id = glCreateProgram();
 	assert_cgp_no_msg(glIsProgram(program_id));
 
-	// Attach Shader to Program
-	glAttachShader(program_id, compute_shader_id);
+	bool const use_cache = program_binary_supported();
+	std::string const key = use_cache ? program_key(sources) : "";
+	if (use_cache && program_cache_load(program_id, key)) {
+		++programs_from_cache;
+		loading_log << "  [info] Shader loaded from cache [ID=" << program_id << "] (" << description << ")\n";
+		return program_id;
+	}
 
-	// Link Program
+	pending_program pending;
+	pending.program_id = program_id;
+	pending.key = key;
+	pending.description = description;
+	for (auto const& source : sources) {
+		GLuint const shader_id = start_compile_shader(source.first, source.second);
+		glAttachShader(program_id, shader_id);
+		pending.shader_ids.push_back(shader_id);
+	}
+#ifndef __EMSCRIPTEN__
+	if (use_cache)
+		glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
 	glLinkProgram(program_id);
 
+	pending_programs.push_back(pending);
+	return program_id;
+}
+
+// Report errors of a linked (or failed) program, release its shaders and fill the cache
+static void finish_program(pending_program const& pending, bool use_cache)
+{
+	GLint is_linked = GL_FALSE;
+	glGetProgramiv(pending.program_id, GL_LINK_STATUS, &is_linked);
+
+	if (is_linked == GL_FALSE) {
+		std::cout << loading_log.str();
+		for (GLuint shader_id : pending.shader_ids) {
+			if (check_compilation(shader_id) == false) {
+				std::cout << "===> Failed to compile the Shader [" << pending.description << "]" << std::endl;
+				std::cout << "The error message from the compiler should be listed above. The program will stop." << std::endl;
+				error_cgp("Failed to compile shader " + pending.description);
+			}
+		}
+		error_cgp("Failed to link shader " + pending.description);
+	}
+
 	// Shader can be detached.
-	glDetachShader(program_id, compute_shader_id);
+	for (GLuint shader_id : pending.shader_ids) {
+		glDetachShader(pending.program_id, shader_id);
+		glDeleteShader(shader_id);
+	}
+	if (use_cache)
+		program_cache_store(pending.program_id, pending.key);
 
 	// Debug info
-	std::string msg = "  [info] Shader compiled succesfully [ID=" + str(program_id) + "]\n";
-	msg            += "         (" + compute_shader_path + ")\n";
-	std::cout << msg << std::endl;
+	loading_log << "  [info] Shader compiled succesfully [ID=" << pending.program_id << "] (" << pending.description << ")\n";
+}
 
-	return program_id;
+void opengl_shader_finish_loading()
+{
+	bool const use_cache = program_binary_supported();
+	int const programs_compiled = int(pending_programs.size());
+
+	// programs are finished in completion order (the cache is written while the others compile)
+	while (!pending_programs.empty()) {
+		size_t ready = 0; // nothing completed: wait for the oldest one
+		if (parallel_compile) {
+			for (size_t k = 0; k < pending_programs.size(); ++k) {
+				GLint completed = GL_FALSE;
+				glGetProgramiv(pending_programs[k].program_id, GL_COMPLETION_STATUS_KHR, &completed);
+				if (completed == GL_TRUE) { ready = k; break; }
+			}
+		}
+		finish_program(pending_programs[ready], use_cache);
+		pending_programs.erase(pending_programs.begin() + ready);
+	}
+
+	double const elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loading_start).count();
+	loading_log << "  [info] " << programs_compiled + programs_from_cache << " programs ready in " << elapsed << " ms ("
+	            << programs_from_cache << " from cache" << (use_cache ? "" : ", cache disabled") << ")\n";
+	std::cout << loading_log.str() << std::endl;
+
+	programs_from_cache = 0;
+	loading_log.str("");
+}
+
+// Valid, stale and rejected cache files: only a valid one is used, the others fall back to the sources and are rewritten
+int opengl_program_cache_selftest()
+{
+	std::string const saved_directory = opengl_program_cache::directory;
+	bool const saved_enabled = opengl_program_cache::enabled;
+	opengl_program_cache::directory = "shader_cache_selftest/";
+	opengl_program_cache::enabled = true;
+	if (!program_binary_supported()) {
+		std::cout << "[program cache] no program binary format: skipped" << std::endl;
+		opengl_program_cache::directory = saved_directory;
+		opengl_program_cache::enabled = saved_enabled;
+		return 0;
+	}
+
+	std::vector<std::pair<GLenum, std::string>> const sources = { { GL_COMPUTE_SHADER,
+		"#version 430\nlayout(local_size_x = 1) in;\nlayout(std430, binding = 0) buffer result_buffer { uint value; };\n"
+		"uniform uint u_value;\nvoid main() { value = u_value; }\n" } };
+	std::string const key = program_key(sources);
+	std::string const path = program_cache_path(key);
+
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+
+	// load the program, tell where it came from, and check that it runs
+	auto load = [&](bool& from_cache) {
+		int const before = programs_from_cache;
+		GLuint const program = opengl_start_program(sources, "program cache selftest");
+		from_cache = programs_from_cache > before;
+		opengl_shader_finish_loading();
+
+		GLuint const expected = 42 + program, zero = 0;
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+		glUseProgram(program);
+		glUniform1ui(glGetUniformLocation(program, "u_value"), expected);
+		glDispatchCompute(1, 1, 1);
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		GLuint value = 0;
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &value);
+		glUseProgram(0);
+		glDeleteProgram(program);
+		return value == expected;
+	};
+	auto read_file = [&path]() {
+		std::ifstream file(path, std::ios::binary);
+		return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	};
+	auto write_file = [&path](std::string const& bytes) {
+		std::ofstream file(path, std::ios::binary);
+		file.write(bytes.data(), bytes.size());
+	};
+
+	// file layout: [key size][key][binary format][binary]
+	size_t const format_offset = sizeof(uint64_t) + key.size();
+	struct cache_case {
+		char const* name;
+		bool from_cache;
+		void (*corrupt)(std::string& bytes, size_t format_offset);
+	};
+	cache_case const cases[] = {
+		{ "valid binary", true, [](std::string&, size_t) {} },
+		{ "stale key (driver update)", false, [](std::string& bytes, size_t) { bytes[sizeof(uint64_t)] ^= 1; } },
+		{ "unknown binary format", false, [](std::string& bytes, size_t offset) { GLenum const bad = 0xFFFF; bytes.replace(offset, sizeof(GLenum), reinterpret_cast<char const*>(&bad), sizeof(GLenum)); } },
+		{ "corrupted binary", false, [](std::string& bytes, size_t offset) {
+			size_t const begin = offset + sizeof(GLenum);
+			bytes.resize(begin + (bytes.size() - begin) / 2);
+			for (size_t k = begin; k < bytes.size(); ++k) bytes[k] = char(k * 131);
+		} },
+	};
+
+	int errors = 0;
+	bool from_cache = false;
+	std::remove(path.c_str());
+	bool const compiled = load(from_cache);
+	if (!compiled || from_cache || read_file().size() <= format_offset) {
+		std::cout << "[program cache] first load: not compiled or not stored" << std::endl;
+		++errors;
+	}
+	for (cache_case const& c : cases) {
+		std::string bytes = read_file();
+		if (bytes.size() <= format_offset + sizeof(GLenum)) break;
+		c.corrupt(bytes, format_offset);
+		write_file(bytes);
+
+		bool const runs = load(from_cache);
+		bool reloaded = false;
+		bool const rewritten = load(reloaded) && reloaded; // a fallback overwrites the file with a valid binary
+		bool const ok = runs && from_cache == c.from_cache && rewritten;
+		std::cout << "[program cache] " << c.name << ": " << (from_cache ? "loaded from cache" : "compiled from source")
+		          << (ok ? ", ok" : ", FAILED") << std::endl;
+		errors += ok ? 0 : 1;
+	}
+
+	glDeleteBuffers(1, &buffer);
+	std::remove(path.c_str());
+#ifdef _WIN32
+	_rmdir(opengl_program_cache::directory.c_str());
+#else
+	rmdir(opengl_program_cache::directory.c_str());
+#endif
+	opengl_program_cache::directory = saved_directory;
+	opengl_program_cache::enabled = saved_enabled;
+	return errors;
+}
+
+// COMPUTE SHADER (only from path)
+void opengl_shader_structure_custom::load(std::string const& compute_shader_path){
+	id = opengl_start_program({ { GL_COMPUTE_SHADER, read_shader_file(compute_shader_path) } }, compute_shader_path);
+}
+
+// VERTEX / FRAGMENT SHADERS
+void opengl_shader_structure_custom::load(std::string const& vertex_shader_path, std::string const& fragment_shader_path){
+	id = opengl_start_program({
+		{ GL_VERTEX_SHADER, read_shader_file(vertex_shader_path) },
+		{ GL_FRAGMENT_SHADER, read_shader_file(fragment_shader_path) } },
+		vertex_shader_path + ", " + fragment_shader_path);
 }
\ No newline at end of file
@@ -45,11 +45,61 @@ struct camera_controller_first_person_custom : camera_controller_first_person {
 struct opengl_shader_structure_custom : opengl_shader_structure {
 	// COMPUTE SHADER 
 	void load(std::string const& compute_shader_path);
+	// VERTEX / FRAGMENT SHADERS
+	void load(std::string const& vertex_shader_path, std::string const& fragment_shader_path);
+	// Note: load() only starts the compilation (or reads the program cache), call opengl_shader_finish_loading() before use
 };
 
+// Linked programs are saved with glGetProgramBinary, keyed by their sources and the driver strings
+struct opengl_program_cache {
+	static std::string directory; // empty: no cache
+	static bool enabled;
+};
+
+// Wait for the programs started with load(), report errors and fill the cache
+void opengl_shader_finish_loading();
+// Valid, stale and rejected cache files (needs a GL context); returns the number of failures
+int opengl_program_cache_selftest();
+
 struct opengl_texture_image_structure_custom : opengl_texture_image_structure {
+	int layers = 1;
+	bool is_view = false; // shares the storage of another texture
+
 	// Initialize a GL_TEXTURE_2D from data
 	void initialize_texture_2d_on_gpu(int width_arg, int height_arg, GLint format_arg=GL_RGB8, GLenum texture_type_arg= GL_TEXTURE_2D, GLint wrap_s= GL_CLAMP_TO_EDGE, GLint wrap_t= GL_CLAMP_TO_EDGE, GLint texture_mag_filter= GL_LINEAR, GLint texture_min_filter= GL_LINEAR, const GLvoid* data = 0);
+	// Initialize a GL_TEXTURE_2D_ARRAY (immutable storage, no data)
+	void initialize_texture_2d_array_on_gpu(int width_arg, int height_arg, int layers_arg, GLint format_arg, GLint wrap_s= GL_REPEAT, GLint wrap_t= GL_REPEAT, GLint texture_mag_filter= GL_NEAREST, GLint texture_min_filter= GL_NEAREST);
+	// One layer of an array seen as a GL_TEXTURE_2D (no copy), e.g. for the debug quads or glGetTexImage
+	void initialize_texture_view(opengl_texture_image_structure_custom const& array, int layer);
+	void release();
+
+	// GPU memory of the storage (0 for views)
+	size_t bytes() const;
+};
+
+// GPU time of a section of commands (GL_TIME_ELAPSED), read without stalling the pipeline
+//  Results arrive one or two frames late: consume() returns the latest section completed since the last call (0: none),
+//  older ones arriving at the same time are dropped (one frame's cost, not two added up).
+//  A section is not measured when every query is still in flight.
+//  end() numbers the sections (0: not measured); consume() can also list every completed one, to attribute them to their frame.
+struct gpu_timer_section {
+	uint64_t section = 0;
+	float ms = 0.f;
+};
+
+struct opengl_gpu_timer {
+	static const int num_queries = 8; // frames in flight when nothing waits for the GPU
+	GLuint queries[num_queries] = {};
+	bool pending[num_queries] = {};
+	uint64_t issued[num_queries] = {}; // order of the sections, to find the latest completed one
+	uint64_t sections = 0;
+	int next = 0;
+	bool active = false;
+
+	void begin();
+	uint64_t end();
+	float consume(std::vector<gpu_timer_section>* completed = nullptr); // ms; completed sections appended to `completed`
+	void release();
 };
 
 struct uniform_generic_structure_custom : uniform_generic_structure {
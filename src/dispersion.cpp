@@ -0,0 +1,77 @@
+#include "dispersion.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const double g = 9.81;
+static const double TWO_PI = 6.283185307179586;
+
+void dispersion_structure::initialize(int resolution_arg, int ocean_size_arg)
+{
+	resolution = resolution_arg;
+	ocean_size = ocean_size_arg;
+	int const N = resolution;
+	size_t const size = size_t(N) * N;
+
+	// same wave vectors as the compute shaders (centered)
+	omega.resize(size);
+	int const half = N >> 1;
+	for (int y = 0; y < N; ++y) {
+		for (int x = 0; x < N; ++x) {
+			double const kx = TWO_PI * ((x + half) % N - half) / ocean_size;
+			double const kz = TWO_PI * ((y + half) % N - half) / ocean_size;
+			omega[size_t(y)*N + x] = float(std::sqrt(g * std::sqrt(kx*kx + kz*kz)));
+		}
+	}
+
+	epoch = 0.0;
+	phase.assign(size, 0.f);
+	next_phase.assign(size, 0.f);
+	next_rows = 0;
+
+	texels.resize(2 * size);
+	for (size_t i = 0; i < size; ++i) {
+		texels[2*i] = omega[i];
+		texels[2*i + 1] = phase[i];
+	}
+}
+
+void dispersion_structure::compute_phases(std::vector<float>& out, double t, int row_begin, int row_end) const
+{
+	// the float omega is the one the shaders multiply by the local time: phases stay continuous across epochs
+	size_t const begin = size_t(row_begin) * resolution, end = size_t(row_end) * resolution;
+	for (size_t i = begin; i < end; ++i) {
+		double const p = double(omega[i]) * t;
+		out[i] = float(p - TWO_PI * std::floor(p / TWO_PI));
+	}
+}
+
+bool dispersion_structure::update(double time)
+{
+	int const N = resolution;
+	double const next_epoch = epoch + epoch_length;
+
+	if (time >= epoch && time < next_epoch) {
+		// spread the next epoch over 64 updates
+		int const rows = std::min(N - next_rows, std::max(1, N / 64));
+		compute_phases(next_phase, next_epoch, next_rows, next_rows + rows);
+		next_rows += rows;
+		return false;
+	}
+
+	double const new_epoch = std::floor(time / epoch_length) * epoch_length;
+	if (new_epoch == next_epoch) {
+		compute_phases(next_phase, new_epoch, next_rows, N);
+		phase.swap(next_phase);
+	}
+	else {
+		// jump in time (or clock reset)
+		compute_phases(phase, new_epoch, 0, N);
+	}
+	epoch = new_epoch;
+	next_rows = 0;
+
+	for (size_t i = 0; i < phase.size(); ++i)
+		texels[2*i + 1] = phase[i];
+	return true;
+}
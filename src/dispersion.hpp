@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+
+// Phases of the waves, exact at any uptime
+//  omega(k)*t is never evaluated with a large float t: the phase is split into
+//   phase(k) = omega(k)*epoch mod 2pi      (per texel, computed in double, wrapped to [0, 2pi))
+//   + omega(k)*(t - epoch)                 (local time, always smaller than ~epoch_length)
+//  The epoch moves by epoch_length steps; the phases of the next epoch are computed a few rows per update beforehand.
+//  GPU layout (spectrum_t.comp.glsl): RG32F texture (omega, phase)
+
+struct dispersion_structure {
+	int resolution = 0;           // N
+	int ocean_size = 0;           // L
+	double epoch_length = 64.0;   // s (local times stay under ~epoch_length: float error ~1e-5 rad)
+
+	double epoch = 0.0;           // phase origin (s)
+	std::vector<float> omega;     // omega(k) = sqrt(g |k|)
+	std::vector<float> phase;     // omega(k) * epoch, wrapped
+	std::vector<float> texels;    // (omega, phase) interleaved for the upload
+
+	void initialize(int resolution_arg, int ocean_size_arg);
+
+	// Move the epoch if `time` left [epoch, epoch + epoch_length); returns true if the phases changed (upload texels)
+	bool update(double time);
+	// Time relative to the epoch, the only time seen by the shaders (the CPU engine keeps it in double)
+	float local_time(double time) const { return float(time - epoch); }
+
+	// internal: phases of the next epoch, filled progressively
+	std::vector<float> next_phase;
+	int next_rows = 0;
+	void compute_phases(std::vector<float>& out, double t, int row_begin, int row_end) const;
+};
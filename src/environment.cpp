@@ -2,6 +2,9 @@
 
 std::string project::path = "";
 float project::gui_scale = 1.5f;
+std::string project::shm_name = "";
+int project::readback_step = 1;
+std::string project::timings_trace_path = "";
 
 environment_structure::environment_structure()
 {
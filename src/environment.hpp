@@ -38,4 +38,13 @@ struct project {
 	// ImGui Scale: change this value (default=1) for larger/smaller gui
 	static float gui_scale;
 
+	// POSIX shared memory name where the displacement map is published (empty = disabled)
+	static std::string shm_name;
+
+	// Downsampling factor of the maps read back from the GPU (1 = full resolution)
+	static int readback_step;
+
+	// File where the per-frame timings are recorded for quality_governor_replay (empty = disabled)
+	static std::string timings_trace_path;
+
 };
@@ -0,0 +1,362 @@
+#include "fft_cpu.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+// REF: http://wwwa.pikara.ne.jp/okojisan/otfft-en/stockham3.html (radix-4), D. H. Bailey "FFTs in external or hierarchical memory" (six-step)
+
+static const double PI_D = 3.14159265358979323846264;
+
+// Multiply by sign*i
+static inline complex_f mul_j(complex_f a, int sign){
+	return complex_f(-sign * a.imag(), sign * a.real());
+}
+
+// RADIX STAGES
+//  y[q + s*(r*p + k)] = w^(p*k) * sum_j x[q + s*(p + j*m)] * W_r^(j*k),  m = len/r
+static void stage_radix_2(int len, int s, complex_f const* tw, complex_f const* x, complex_f* y)
+{
+	int const m = len / 2;
+	for (int p = 0; p < m; ++p) {
+		complex_f const w1 = tw[p];
+		for (int q = 0; q < s; ++q) {
+			complex_f const a = x[q + s*p];
+			complex_f const b = x[q + s*(p + m)];
+			y[q + s*(2*p + 0)] = a + b;
+			y[q + s*(2*p + 1)] = complex_prod(a - b, w1);
+		}
+	}
+}
+
+static void stage_radix_4(int len, int s, int sign, complex_f const* tw, complex_f const* x, complex_f* y)
+{
+	int const m = len / 4;
+	for (int p = 0; p < m; ++p) {
+		complex_f const w1 = tw[3*p + 0];
+		complex_f const w2 = tw[3*p + 1];
+		complex_f const w3 = tw[3*p + 2];
+		for (int q = 0; q < s; ++q) {
+			complex_f const a = x[q + s*(p + 0*m)];
+			complex_f const b = x[q + s*(p + 1*m)];
+			complex_f const c = x[q + s*(p + 2*m)];
+			complex_f const d = x[q + s*(p + 3*m)];
+
+			complex_f const apc = a + c, amc = a - c;
+			complex_f const bpd = b + d, jbmd = mul_j(b - d, sign);
+
+			complex_f* out = y + q + s*4*p;
+			out[0]   = apc + bpd;
+			out[s]   = complex_prod(amc + jbmd, w1);
+			out[2*s] = complex_prod(apc - bpd, w2);
+			out[3*s] = complex_prod(amc - jbmd, w3);
+		}
+	}
+}
+
+static void stage_radix_8(int len, int s, int sign, complex_f const* tw, complex_f const* x, complex_f* y)
+{
+	float const r2 = float(1.0 / std::sqrt(2.0));
+	int const m = len / 8;
+	for (int p = 0; p < m; ++p) {
+		complex_f const* w = tw + 7*p;
+		for (int q = 0; q < s; ++q) {
+			complex_f u[8];
+			for (int j = 0; j < 8; ++j)
+				u[j] = x[q + s*(p + j*m)];
+
+			// 4-point transforms of the even and odd inputs
+			complex_f const e0 = u[0] + u[4], e1 = u[0] - u[4], e2 = u[2] + u[6], e3 = mul_j(u[2] - u[6], sign);
+			complex_f const o0 = u[1] + u[5], o1 = u[1] - u[5], o2 = u[3] + u[7], o3 = mul_j(u[3] - u[7], sign);
+
+			complex_f const E[4] = { e0 + e2, e1 + e3, e0 - e2, e1 - e3 };
+			complex_f O[4]       = { o0 + o2, o1 + o3, o0 - o2, o1 - o3 };
+
+			// O_k *= W8^k
+			O[1] = complex_f(O[1].real() - sign*O[1].imag(), O[1].imag() + sign*O[1].real()) * r2;
+			O[2] = mul_j(O[2], sign);
+			O[3] = complex_f(-O[3].real() - sign*O[3].imag(), -O[3].imag() + sign*O[3].real()) * r2;
+
+			complex_f* out = y + q + s*8*p;
+			out[0] = E[0] + O[0];
+			out[4*s] = complex_prod(E[0] - O[0], w[3]);
+			for (int k = 1; k < 4; ++k) {
+				out[k*s]       = complex_prod(E[k] + O[k], w[k - 1]);
+				out[(k + 4)*s] = complex_prod(E[k] - O[k], w[k + 3]);
+			}
+		}
+	}
+}
+
+
+// WORKER POOL
+void worker_pool_structure::initialize(int num_threads_arg)
+{
+	shutdown();
+	num_threads = std::max(1, num_threads_arg);
+	stop = false;
+	for (int w = 1; w < num_threads; ++w)
+		threads.emplace_back([this]() { worker_loop(); });
+}
+
+void worker_pool_structure::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	wake.notify_all();
+	for (auto& t : threads) t.join();
+	threads.clear();
+}
+
+void worker_pool_structure::worker_loop()
+{
+	unsigned int seen = 0;
+	while (true) {
+		std::function<void(int)> const* fn;
+		int count;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this, seen]() { return stop || generation != seen; });
+			if (stop) return;
+			seen = generation;
+			fn = job;
+			count = job_count;
+		}
+		for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+			(*fn)(i);
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--busy == 0) done.notify_one();
+	}
+}
+
+void worker_pool_structure::run(int count, std::function<void(int)> const& fn)
+{
+	if (threads.empty() || count <= 1) {
+		for (int i = 0; i < count; ++i) fn(i);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &fn;
+		job_count = count;
+		next = 0;
+		busy = int(threads.size());
+		++generation;
+	}
+	wake.notify_all();
+
+	// the calling thread works too
+	for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+		fn(i);
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this]() { return busy == 0; });
+	job = nullptr;
+}
+
+
+// FFT STRUCTURE
+void fft_cpu_structure::initialize(int resolution_arg, int sign_arg, int num_threads_arg)
+{
+	if (resolution_arg < 2 || (resolution_arg & (resolution_arg - 1)) != 0)
+		throw std::invalid_argument("fft_cpu: resolution must be 2^k");
+
+	resolution = resolution_arg;
+	sign = sign_arg;
+	num_threads = num_threads_arg > 0 ? num_threads_arg : std::max(1, int(std::thread::hardware_concurrency()));
+	num_threads = std::max(1, std::min(num_threads, resolution / 64)); // small fields are not worth the synchronization
+	if (pool.num_threads != num_threads || (num_threads > 1 && pool.threads.empty()))
+		pool.initialize(num_threads);
+
+	// radix plan: as many radix-8 as possible, never more than one radix-2 (only for N=2)
+	int log2n = 0;
+	while ((1 << log2n) < resolution) ++log2n;
+	int n8 = log2n / 3, n4 = 0, n2 = 0;
+	if (log2n % 3 == 2) n4 = 1;
+	if (log2n % 3 == 1) {
+		if (n8 > 0) { --n8; n4 = 2; }
+		else n2 = 1;
+	}
+	radix.clear();
+	radix.insert(radix.end(), n8, 8);
+	radix.insert(radix.end(), n4, 4);
+	radix.insert(radix.end(), n2, 2);
+
+	// twiddles computed in double precision
+	twiddle.clear();
+	int len = resolution;
+	for (int r : radix) {
+		int const m = len / r;
+		std::vector<complex_f> tw(size_t(m) * (r - 1));
+		for (int p = 0; p < m; ++p) {
+			for (int k = 1; k < r; ++k) {
+				double const angle = sign * 2.0 * PI_D * double(p) * k / len;
+				tw[size_t(p)*(r - 1) + (k - 1)] = complex_f(float(std::cos(angle)), float(std::sin(angle)));
+			}
+		}
+		twiddle.push_back(std::move(tw));
+		len = m;
+	}
+}
+
+void fft_cpu_structure::transform_1d(complex_f* x, complex_f* work) const
+{
+	complex_f* src = x;
+	complex_f* dst = work;
+	int len = resolution, s = 1;
+	for (size_t stage = 0; stage < radix.size(); ++stage) {
+		int const r = radix[stage];
+		complex_f const* tw = twiddle[stage].data();
+		if (r == 8) stage_radix_8(len, s, sign, tw, src, dst);
+		else if (r == 4) stage_radix_4(len, s, sign, tw, src, dst);
+		else stage_radix_2(len, s, tw, src, dst);
+		std::swap(src, dst);
+		s *= r;
+		len /= r;
+	}
+	if (src != x)
+		std::memcpy(x, src, sizeof(complex_f) * resolution);
+}
+
+// Scratch of the calling thread, grown on demand: passes run as tasks every frame do not allocate
+static complex_f* thread_scratch(size_t size)
+{
+	thread_local std::vector<complex_f> scratch;
+	if (scratch.size() < size) scratch.resize(size);
+	return scratch.data();
+}
+
+// Transform rows [begin, end) of a N x N field
+static void transform_rows(fft_cpu_structure const& fft, complex_f* data, int begin, int end)
+{
+	int const N = fft.resolution;
+	complex_f* work = thread_scratch(N);
+	for (int row = begin; row < end; ++row)
+		fft.transform_1d(data + size_t(row) * N, work);
+}
+
+// Transform the columns of strips [begin, end), gathering FFT_COLUMN_STRIP columns in a contiguous buffer
+static void transform_column_strips(fft_cpu_structure const& fft, complex_f* data, int begin, int end)
+{
+	int const N = fft.resolution;
+	int const strip = std::min(FFT_COLUMN_STRIP, N);
+	complex_f* buffer = thread_scratch(size_t(strip + 1) * N);
+	complex_f* work = buffer + size_t(strip) * N;
+	for (int k = begin; k < end; ++k) {
+		int const col = k * strip;
+		for (int row = 0; row < N; ++row)
+			for (int j = 0; j < strip; ++j)
+				buffer[size_t(j)*N + row] = data[size_t(row)*N + col + j];
+		for (int j = 0; j < strip; ++j)
+			fft.transform_1d(buffer + size_t(j)*N, work);
+		for (int row = 0; row < N; ++row)
+			for (int j = 0; j < strip; ++j)
+				data[size_t(row)*N + col + j] = buffer[size_t(j)*N + row];
+	}
+}
+
+void transpose_blocked(complex_f* data, int n, int block_row_begin, int block_row_end)
+{
+	int const B = std::min(FFT_TRANSPOSE_BLOCK, n);
+	int const num_blocks = n / B;
+	for (int bi = block_row_begin; bi < block_row_end; ++bi) {
+		// diagonal block
+		for (int i = bi*B; i < (bi + 1)*B; ++i)
+			for (int j = i + 1; j < (bi + 1)*B; ++j)
+				std::swap(data[size_t(i)*n + j], data[size_t(j)*n + i]);
+		// pairs of blocks (bi, bj) <-> (bj, bi)
+		for (int bj = bi + 1; bj < num_blocks; ++bj)
+			for (int i = bi*B; i < (bi + 1)*B; ++i)
+				for (int j = bj*B; j < (bj + 1)*B; ++j)
+					std::swap(data[size_t(i)*n + j], data[size_t(j)*n + i]);
+	}
+}
+
+int fft_cpu_structure::pass_size(int pass) const
+{
+	if (!use_six_step())
+		return pass == 0 ? resolution : resolution / std::min(FFT_COLUMN_STRIP, resolution);
+	return (pass % 2 == 0) ? resolution : resolution / std::min(FFT_TRANSPOSE_BLOCK, resolution);
+}
+
+void fft_cpu_structure::run_pass(int pass, complex_f* data, int begin, int end) const
+{
+	if (!use_six_step()) {
+		if (pass == 0) transform_rows(*this, data, begin, end);
+		else transform_column_strips(*this, data, begin, end);
+		return;
+	}
+	// six-step: every pass streams the whole field once with unit stride
+	if (pass % 2 == 0) transform_rows(*this, data, begin, end);
+	else transpose_blocked(data, resolution, begin, end);
+}
+
+void fft_cpu_structure::transform_2d(complex_f* data) const
+{
+	for (int pass = 0; pass < num_passes(); ++pass) {
+		int const size = pass_size(pass);
+		int const chunks = std::min(size, 4 * num_threads); // the block rows of the transpose are unbalanced
+		pool.run(chunks, [&](int k) {
+			run_pass(pass, data, (size * k) / chunks, (size * (k + 1)) / chunks);
+		});
+	}
+}
+
+double fft_cpu_structure::bytes_per_transform_2d() const
+{
+	double const field = double(resolution) * resolution * sizeof(complex_f);
+	int const passes = use_six_step() ? 4 : 2; // (rows, transpose, rows, transpose) or (rows, column strips)
+	return 2.0 * passes * field; // read + write per pass
+}
+
+
+// BENCHMARK
+template <typename F>
+static double best_time(int iterations, F const& fn)
+{
+	double best = 1e30;
+	for (int it = 0; it < iterations; ++it) {
+		auto const t0 = std::chrono::steady_clock::now();
+		fn();
+		auto const t1 = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+	}
+	return best;
+}
+
+void fft_cpu_benchmark(int resolution, int iterations)
+{
+	fft_cpu_structure fft;
+	fft.initialize(resolution);
+
+	// STREAM triad (a = b + s*c) on arrays well beyond the last level cache
+	size_t const stream_size = size_t(1) << 24;
+	std::vector<double> a(stream_size, 0.0), b(stream_size, 1.0), c(stream_size, 2.0);
+	double const scalar = 3.0;
+	int const stream_chunks = 1024;
+	double const stream_time = best_time(iterations, [&]() {
+		fft.pool.run(stream_chunks, [&](int k) {
+			size_t const begin = stream_size * k / stream_chunks, end = stream_size * (k + 1) / stream_chunks;
+			for (size_t i = begin; i < end; ++i)
+				a[i] = b[i] + scalar * c[i];
+		});
+	});
+	double const stream_bandwidth = 3.0 * sizeof(double) * stream_size / stream_time;
+
+	// 2D transform
+	size_t const field_size = size_t(resolution) * resolution;
+	std::vector<complex_f> data(field_size);
+	for (size_t i = 0; i < field_size; ++i)
+		data[i] = complex_f(float(i % 7) - 3.f, float(i % 5) - 2.f);
+	double const fft_time = best_time(iterations, [&]() { fft.transform_2d(data.data()); });
+	double const fft_bandwidth = fft.bytes_per_transform_2d() / fft_time;
+
+	std::cout << "[FFT benchmark] " << resolution << "x" << resolution
+	          << " (" << (fft.use_six_step() ? "six-step" : "rows + column strips") << ", " << fft.num_threads << " threads)" << std::endl;
+	std::cout << "  STREAM triad: " << stream_bandwidth * 1e-9 << " GB/s" << std::endl;
+	std::cout << "  2D FFT: " << fft_time * 1e3 << " ms, " << fft_bandwidth * 1e-9 << " GB/s ("
+	          << 100.0 * fft_bandwidth / stream_bandwidth << "% of STREAM)" << std::endl;
+}
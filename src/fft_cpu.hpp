@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <complex>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// CPU FFT used for very large resolutions (4096x4096 and beyond)
+//  Same convention as fft_rows/fft_columns.comp.glsl: unnormalized transform, exponent sign +1 by default
+//  - 1D transforms: Stockham autosort with radix-8/4/2 stages (in cache)
+//  - 2D transforms: rows + column strips for small fields, six-step (rows, blocked transpose, rows, blocked transpose) above FFT_SIX_STEP_THRESHOLD
+//  - each pass of a 2D transform is split in independent items (rows, strips, block rows) so it can be scheduled as tasks
+
+#define FFT_SIX_STEP_THRESHOLD 2048 // side of the field from which the six-step path is chosen
+#define FFT_TRANSPOSE_BLOCK 32      // tile side of the blocked transpose (32x32 complex = 8KB)
+#define FFT_COLUMN_STRIP 8          // number of columns gathered together (one 64B cache line of complex float)
+
+using complex_f = std::complex<float>;
+
+// COMPLEX OPERATIONS (std::complex operator* goes through the NaN-checking __mulsc3 without -ffast-math)
+inline complex_f complex_prod(complex_f a, complex_f b){
+	return complex_f(a.real()*b.real() - a.imag()*b.imag(), a.real()*b.imag() + a.imag()*b.real());
+}
+
+// Persistent workers for transform_2d and the benchmark: the threads are created once, not per pass
+//  run(count, fn) calls fn(i) for i in [0, count), indices are pulled one at a time by the workers and the caller
+struct worker_pool_structure {
+	int num_threads = 1; // including the calling thread
+
+	void initialize(int num_threads_arg);
+	void run(int count, std::function<void(int)> const& fn); // blocks until every index is done
+	void shutdown();
+	~worker_pool_structure() { shutdown(); }
+
+	// internal state
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	std::function<void(int)> const* job = nullptr;
+	int job_count = 0;
+	std::atomic<int> next{ 0 };
+	int busy = 0;                 // workers still on the current job
+	unsigned int generation = 0;  // incremented for each job
+	bool stop = false;
+
+	void worker_loop();
+};
+
+struct fft_cpu_structure {
+	int resolution = 0;   // N (must be 2^k)
+	int sign = 1;         // +1: synthesis (GPU convention), -1: analysis
+	int num_threads = 1;
+
+	std::vector<int> radix;                       // radix of each Stockham stage
+	std::vector<std::vector<complex_f>> twiddle;  // per stage: w^(p*k) for p < len/r, 1 <= k < r
+	mutable worker_pool_structure pool;           // transform_2d only (the CPU engine schedules the passes itself)
+
+	void initialize(int resolution_arg, int sign_arg = 1, int num_threads_arg = 0);
+
+	bool use_six_step() const { return resolution >= FFT_SIX_STEP_THRESHOLD; }
+
+	// 1D transform of N contiguous values in place (work: N values)
+	void transform_1d(complex_f* x, complex_f* work) const;
+
+	// 2D transform of a N x N row-major field in place
+	void transform_2d(complex_f* data) const;
+
+	// Passes of transform_2d: items [begin, end) of a pass are independent, passes must run in order
+	int num_passes() const { return use_six_step() ? 4 : 2; }
+	int pass_size(int pass) const;
+	void run_pass(int pass, complex_f* data, int begin, int end) const;
+
+	// Bytes read+written by one transform_2d call (used to report the sustained bandwidth)
+	double bytes_per_transform_2d() const;
+};
+
+// Square in-place transpose, tiled by FFT_TRANSPOSE_BLOCK: item bi swaps the blocks (bi, bj >= bi) with (bj, bi)
+void transpose_blocked(complex_f* data, int n, int block_row_begin, int block_row_end);
+
+// Time the 2D transform against a STREAM triad and print the sustained bandwidth of both
+void fft_cpu_benchmark(int resolution, int iterations);
@@ -0,0 +1,229 @@
+#include "flight_benchmark.hpp"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using cgp::vec3;
+
+// CAMERA PATH
+void camera_path::evaluate(float time, vec3& eye, vec3& target) const
+{
+	if (keys.empty()) return;
+	if (time <= keys.front().time) { eye = keys.front().eye; target = keys.front().target; return; }
+	if (time >= keys.back().time) { eye = keys.back().eye; target = keys.back().target; return; }
+
+	size_t k = 1;
+	while (keys[k].time < time) ++k;
+	camera_path_key const& a = keys[k - 1];
+	camera_path_key const& b = keys[k];
+	float const s = b.time > a.time ? (time - a.time) / (b.time - a.time) : 1.f;
+	eye = (1.f - s) * a.eye + s * b.eye;
+	target = (1.f - s) * a.target + s * b.target;
+}
+
+bool camera_path::load(std::string const& filename)
+{
+	std::ifstream in(filename);
+	if (!in) {
+		std::cout << "[flight] cannot read " << filename << std::endl;
+		return false;
+	}
+
+	keys.clear();
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.empty() || line[0] == '#') continue;
+		std::istringstream fields(line);
+		camera_path_key key;
+		fields >> key.time >> key.eye.x >> key.eye.y >> key.eye.z >> key.target.x >> key.target.y >> key.target.z;
+		if (fields && (keys.empty() || key.time >= keys.back().time)) keys.push_back(key);
+	}
+	if (keys.size() < 2) {
+		std::cout << "[flight] " << filename << " needs at least two camera keys" << std::endl;
+		return false;
+	}
+	float const start = keys.front().time;
+	for (camera_path_key& key : keys) key.time -= start;
+	return true;
+}
+
+camera_path camera_path::procedural(float duration, float water_height)
+{
+	// same speed as the keyboard controls (8 units/s)
+	float const speed = 8.f;
+	float const quarter = duration / 4.f;
+	float const low = water_height + 1.f, high = water_height + 120.f; // crosses the temporal LOD bands (20, 80)
+	camera_path path;
+	auto add = [&path](float time, vec3 eye, vec3 direction) { path.keys.push_back({ time, eye, eye + 10.f * direction }); };
+
+	// low flight over the tile borders
+	vec3 const start = { 0.f, low, 0.f };
+	vec3 const end_of_flight = start + vec3(speed * quarter, 0.f, 0.f);
+	add(0.f, start, { 1.f, -0.1f, 0.f });
+	add(quarter, end_of_flight, { 1.f, -0.1f, 0.f });
+
+	// full turn on the spot: every tile enters and leaves the view cone
+	int const turn_keys = 16;
+	for (int k = 1; k <= turn_keys; ++k) {
+		float const angle = 2.f * 3.14159265359f * k / turn_keys;
+		add(quarter * (1.f + float(k) / turn_keys), end_of_flight, { std::cos(angle), -0.1f, std::sin(angle) });
+	}
+
+	// climb looking down, then descend back to the start
+	vec3 const top = end_of_flight + vec3(0.f, high - low, speed * quarter);
+	add(3.f * quarter, top, { 0.f, -0.7f, 0.7f });
+	add(duration, start, { -0.7f, -0.2f, -0.7f });
+	return path;
+}
+
+bool camera_path_recorder::open(std::string const& filename)
+{
+	file.open(filename);
+	if (!file) {
+		std::cout << "[flight] cannot write " << filename << std::endl;
+		return false;
+	}
+	file << "# time eye.x eye.y eye.z target.x target.y target.z" << std::endl;
+	file.precision(10); // times of the simulation clock (possibly days)
+	return true;
+}
+
+void camera_path_recorder::record(double time, vec3 const& eye, vec3 const& target)
+{
+	file << time << " " << eye.x << " " << eye.y << " " << eye.z << " " << target.x << " " << target.y << " " << target.z << "\n";
+}
+
+
+// BENCHMARK
+std::string json_string(std::string const& text)
+{
+	std::string quoted = "\"";
+	for (char c : text) {
+		if (c == '"' || c == '\\') quoted += '\\';
+		if (static_cast<unsigned char>(c) >= 0x20) quoted += c;
+	}
+	return quoted + "\"";
+}
+
+bool flight_benchmark_structure::initialize(float water_height)
+{
+	if (!path_file.empty()) {
+		if (!path.load(path_file)) return false;
+	}
+	else
+		path = camera_path::procedural(duration, water_height);
+
+	records.clear();
+	records.reserve(warmup_frames + frame_count());
+	frame = 0;
+	last_frame = std::chrono::steady_clock::now();
+	return true;
+}
+
+void flight_benchmark_structure::record(flight_frame_record record)
+{
+	auto const now = std::chrono::steady_clock::now();
+	record.frame_ms = std::chrono::duration<float, std::milli>(now - last_frame).count();
+	last_frame = now;
+	if (frame >= warmup_frames) records.push_back(record);
+	++frame;
+}
+
+void flight_benchmark_structure::add_gpu_time(int timer, gpu_timer_section const& section)
+{
+	// the frames still waiting for the GPU are the last few; sections of the warmup frames match none
+	for (auto r = records.rbegin(); r != records.rend(); ++r) {
+		if (r->gpu_sections[timer] == section.section) {
+			r->gpu_ms += section.ms;
+			r->gpu_sections[timer] = 0;
+			return;
+		}
+	}
+}
+
+struct flight_statistics {
+	double mean = 0.0, p50 = 0.0, p95 = 0.0, p99 = 0.0, max = 0.0;
+};
+
+static flight_statistics statistics_of(std::vector<float> values)
+{
+	flight_statistics s;
+	if (values.empty()) return s;
+	std::sort(values.begin(), values.end());
+	// nearest rank
+	auto percentile = [&values](double p) { return values[std::min(values.size() - 1, size_t(std::ceil(p * values.size())) - 1)]; };
+	for (float v : values) s.mean += v;
+	s.mean /= values.size();
+	s.p50 = percentile(0.50);
+	s.p95 = percentile(0.95);
+	s.p99 = percentile(0.99);
+	s.max = values.back();
+	return s;
+}
+
+static const std::vector<float> histogram_edges_ms = { 0.5f, 1.f, 2.f, 4.f, 8.f, 12.f, 16.7f, 25.f, 33.3f, 50.f, 100.f };
+
+static void write_timing(std::ostream& out, char const* name, std::vector<float> const& values)
+{
+	flight_statistics const s = statistics_of(values);
+	std::vector<int> counts(histogram_edges_ms.size() + 1, 0); // last bin: above the last edge
+	for (float v : values)
+		++counts[std::upper_bound(histogram_edges_ms.begin(), histogram_edges_ms.end(), v) - histogram_edges_ms.begin()];
+
+	out << "  \"" << name << "\": { \"mean\": " << s.mean << ", \"p50\": " << s.p50 << ", \"p95\": " << s.p95
+		<< ", \"p99\": " << s.p99 << ", \"max\": " << s.max << ",\n    \"histogram\": { \"edges\": [";
+	for (size_t k = 0; k < histogram_edges_ms.size(); ++k)
+		out << (k ? ", " : "") << histogram_edges_ms[k];
+	out << "], \"counts\": [";
+	for (size_t k = 0; k < counts.size(); ++k)
+		out << (k ? ", " : "") << counts[k];
+	out << "] } },\n";
+}
+
+bool flight_benchmark_structure::write_report(std::string const& configuration) const
+{
+	std::vector<float> cpu, gpu, wall;
+	double draw_calls = 0, tiles_drawn = 0, tiles_culled = 0, tiles_lq = 0;
+	int keyframes = 0;
+	for (flight_frame_record const& r : records) {
+		cpu.push_back(r.cpu_ms);
+		if (r.gpu_measured && r.gpu_sections[0] == 0 && r.gpu_sections[1] == 0)
+			gpu.push_back(r.gpu_ms);
+		wall.push_back(r.frame_ms);
+		draw_calls += r.draw_calls;
+		tiles_drawn += r.tiles_drawn;
+		tiles_culled += r.tiles_culled;
+		tiles_lq += r.tiles_lq;
+		keyframes += r.keyframe ? 1 : 0;
+	}
+	double const n = std::max<size_t>(records.size(), 1);
+
+	std::ofstream out(report_file);
+	if (!out) {
+		std::cout << "[flight] cannot write " << report_file << std::endl;
+		return false;
+	}
+	out << std::fixed << std::setprecision(3);
+	out << "{\n";
+	out << "  \"configuration\": " << configuration << ",\n";
+	out << "  \"path\": " << json_string(path_file.empty() ? "procedural" : path_file) << ",\n";
+	out << "  \"seed\": " << seed << ", \"time_step\": " << std::setprecision(6) << time_step << std::setprecision(3) << ", \"warmup_frames\": " << warmup_frames << ", \"frames\": " << records.size() << ", \"gpu_frames\": " << gpu.size() << ",\n";
+	write_timing(out, "cpu_ms", cpu);
+	write_timing(out, "gpu_ms", gpu);
+	write_timing(out, "frame_ms", wall);
+	out << "  \"per_frame\": { \"draw_calls\": " << draw_calls / n << ", \"tiles_drawn\": " << tiles_drawn / n
+		<< ", \"tiles_culled\": " << tiles_culled / n << ", \"tiles_lq\": " << tiles_lq / n << " },\n";
+	out << "  \"keyframes\": " << keyframes << "\n";
+	out << "}\n";
+
+	flight_statistics const c = statistics_of(cpu), g = statistics_of(gpu);
+	std::cout << std::fixed << std::setprecision(2)
+		<< "[flight] " << records.size() << " frames: CPU p50 " << c.p50 << " / p95 " << c.p95 << " / p99 " << c.p99 << " ms, "
+		<< "GPU p50 " << g.p50 << " / p95 " << g.p95 << " / p99 " << g.p99 << " ms, "
+		<< tiles_culled / n << " tiles culled per frame -> " << report_file << std::endl;
+	std::cout.unsetf(std::ios::fixed);
+	std::cout.precision(6);
+	return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "cgp_custom.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Scripted camera flight (--benchmark-flight): every run renders the same frames with the same camera poses
+//  - fixed time step, fixed spectrum seed, fixed window size, no vsync, no quality governor,
+//    temporal LOD at a fixed pressure (not adaptive: the keyframes do not depend on the speed of the machine)
+//  - the path is procedural (low flight, full turn, climb through the temporal LOD bands, descent) or a recorded file (--record-flight)
+//  - per frame: CPU time, GPU time (simulation + tiles), wall clock frame time, draw calls, drawn / culled / low quality tiles
+//  - nothing waits for the GPU: frame_ms is the throughput with the CPU and the GPU overlapped (not the latency of one frame);
+//    the timer queries are read when they complete, one or more frames later, and added to the frame that issued them
+//  - the JSON report gives mean/p50/p95/p99/max and histograms; the warmup frames (compilation, initial spectrum) are excluded
+
+struct camera_path_key {
+	float time = 0.f;
+	cgp::vec3 eye, target;
+};
+
+struct camera_path {
+	std::vector<camera_path_key> keys; // sorted by time
+
+	float duration() const { return keys.empty() ? 0.f : keys.back().time; }
+	// Linear interpolation between the keys (clamped at both ends)
+	void evaluate(float time, cgp::vec3& eye, cgp::vec3& target) const;
+
+	// One key per line: "time eye.x eye.y eye.z target.x target.y target.z", times are shifted to start at 0
+	bool load(std::string const& filename);
+	static camera_path procedural(float duration, float water_height);
+};
+
+// Writes the camera of every frame in the camera_path format
+struct camera_path_recorder {
+	std::ofstream file;
+
+	bool open(std::string const& filename);
+	bool is_open() const { return file.is_open(); }
+	void record(double time, cgp::vec3 const& eye, cgp::vec3 const& target);
+};
+
+struct flight_frame_record {
+	float cpu_ms = 0.f;     // display_frame on CPU (simulation of the CPU engine included)
+	float gpu_ms = 0.f;     // simulation + tiles (GPU timer queries)
+	float frame_ms = 0.f;   // wall clock, frame to frame
+	int draw_calls = 0;
+	int tiles_drawn = 0, tiles_culled = 0, tiles_lq = 0;
+	bool keyframe = false;
+
+	uint64_t gpu_sections[2] = {}; // simulation and render timer sections still in flight (0: none)
+	bool gpu_measured = true;      // false: a section was not measured, the frame is left out of the GPU times
+};
+
+struct flight_benchmark_structure {
+	bool enabled = false;
+	std::string path_file;                          // empty: procedural path
+	std::string report_file = "flight_benchmark.json";
+	unsigned int seed = 1;
+	float time_step = 1.f / 60.f;
+	float duration = 20.f;                          // procedural path only
+	int warmup_frames = 30;
+	int lod_pressure = 0;                           // temporal LOD pressure held during the flight (band periods in the report)
+
+	camera_path path;
+	std::vector<flight_frame_record> records;
+	int frame = 0;
+	std::chrono::steady_clock::time_point last_frame;
+
+	bool initialize(float water_height);
+	bool finished() const { return enabled && frame >= warmup_frames + frame_count(); }
+	int frame_count() const { return int(path.duration() / time_step) + 1; }
+	// Path time of the current frame (the warmup frames stay at the start)
+	float path_time() const { return std::max(0, frame - warmup_frames) * time_step; }
+
+	void record(flight_frame_record record);
+	// Completed section of timer 0 (simulation) or 1 (render), added to the GPU time of the frame that issued it
+	void add_gpu_time(int timer, gpu_timer_section const& section);
+	// Summary on stdout and JSON report; `configuration` is written as is (a JSON object)
+	bool write_report(std::string const& configuration) const;
+};
+
+// Quoted and escaped for the JSON report
+std::string json_string(std::string const& text);
@@ -3,7 +3,15 @@
 #include "cgp/cgp.hpp" // Give access to the complete CGP library
 #include "cgp_custom.hpp"
 #include "environment.hpp" // The general scene environment + project variable
+#include "fft_cpu.hpp" // CPU FFT benchmark
+#include "ocean_cpu.hpp" // CPU engine benchmark
+#include "shm_heightfield.hpp" // shared memory self test
+#include "readback_ring.hpp" // readback self test
+#include "quality_governor.hpp" // offline replay of recorded timings
+#include "precision_harness.hpp" // engines vs double precision reference
 #include <iostream> 
+#include <string>
+#include <cstdlib>
 
 
 // Custom scene of this code
@@ -28,22 +36,76 @@ void animation_loop();
 
 timer_fps fps_record;
 
-int main(int, char* argv[])
+int main(int argc, char* argv[])
 {
 	std::cout << "Run " << argv[0] << std::endl;
 
+	// Offline benchmark of the CPU FFT, no window needed: ./{executable} --benchmark-fft [resolution]
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-fft") {
+		fft_cpu_benchmark(argc > 2 ? std::atoi(argv[2]) : 4096, 5);
+		return 0;
+	}
+	// Serial CPU engine vs task graph: ./{executable} --benchmark-cpu-engine [resolution]
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-cpu-engine") {
+		ocean_cpu_benchmark(argc > 2 ? std::atoi(argv[2]) : 1024, 30);
+		return 0;
+	}
+	// Publisher + reader process checking for torn frames: ./{executable} --shm-selftest [resolution]
+	if (argc > 1 && std::string(argv[1]) == "--shm-selftest") {
+		return shm_heightfield_selftest(argc > 2 ? std::atoi(argv[2]) : 256, 3.0) == 0 ? 0 : 1;
+	}
+	// Quality governor on a trace written by --record-timings: ./{executable} --governor-replay trace.txt [target_ms]
+	if (argc > 2 && std::string(argv[1]) == "--governor-replay") {
+		return quality_governor_replay(argv[2], argc > 3 ? float(std::atof(argv[3])) : 16.7f) < 0 ? 1 : 0;
+	}
 	
 
 	// ************************ //
 	//     INITIALISATION
 	// ************************ //
 
+	// Scripted camera flight: ./{executable} --benchmark-flight [report.json] [--flight-path path.txt] [--flight-seed s]
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string(argv[i]) == "--benchmark-flight") {
+			scene.flight.enabled = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-') scene.flight.report_file = argv[++i];
+		}
+		if (std::string(argv[i]) == "--flight-path" && i + 1 < argc) scene.flight.path_file = argv[++i];
+		if (std::string(argv[i]) == "--flight-seed" && i + 1 < argc) scene.flight.seed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+	}
+
 	// Standard Initialization of an OpenGL ready window
 	// scene.debug_window = standard_window_initialization(360,360);
-	scene.window = standard_window_initialization();
+	scene.window = scene.flight.enabled ? standard_window_initialization(1280, 720) : standard_window_initialization();
+	if (scene.flight.enabled) glfwSwapInterval(0); // measure the frames, not the display
 
 	// Initialize System Info
 	project::path = cgp::project_path_find(argv[0], "shaders/");
+	opengl_program_cache::directory = project::path + "shader_cache/";
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string(argv[i]) == "--no-shader-cache") opengl_program_cache::enabled = false;
+		if (std::string(argv[i]) == "--publish-shm" && i + 1 < argc) project::shm_name = argv[++i];
+		if (std::string(argv[i]) == "--readback-step" && i + 1 < argc) project::readback_step = std::atoi(argv[++i]);
+		if (std::string(argv[i]) == "--record-timings" && i + 1 < argc) project::timings_trace_path = argv[++i];
+		if (std::string(argv[i]) == "--record-flight" && i + 1 < argc) scene.flight_recorder.open(argv[++i]);
+	}
+
+	// Asynchronous readback checks, need a GL context: ./{executable} --readback-selftest
+	if (argc > 1 && std::string(argv[1]) == "--readback-selftest") {
+		int const errors = readback_ring_selftest();
+		glfwDestroyWindow(scene.window.glfw_window);
+		glfwTerminate();
+		return errors == 0 ? 0 : 1;
+	}
+	// Program cache fallback on stale, unknown-format and corrupted binaries: ./{executable} --shader-cache-selftest
+	if (argc > 1 && std::string(argv[1]) == "--shader-cache-selftest") {
+		int const errors = opengl_program_cache_selftest();
+		glfwDestroyWindow(scene.window.glfw_window);
+		glfwTerminate();
+		return errors == 0 ? 0 : 1;
+	}
 
 	// Initialize default shaders
 	initialize_default_shaders();
@@ -51,8 +113,30 @@ int main(int, char* argv[])
 
 	// Custom scene initialization
 	std::cout << "Initialize data of the scene ..." << std::endl;
+	bool const flight_requested = scene.flight.enabled;
 	scene.initialize();
 	std::cout << "Initialization finished\n" << std::endl;
+	if (flight_requested && !scene.flight.enabled) return 1; // camera path not readable
+
+	// Simulation time with and without foam: ./{executable} --benchmark-foam [keyframes]
+	if (argc > 1 && std::string(argv[1]) == "--benchmark-foam") {
+		bool const within_budget = scene.foam_benchmark(argc > 2 ? std::atoi(argv[2]) : 120);
+		glfwDestroyWindow(scene.window.glfw_window);
+		glfwTerminate();
+		return within_budget ? 0 : 1;
+	}
+
+	// Every CPU and GPU variant against the double precision reference: ./{executable} --precision-harness [report.csv]
+	if (argc > 1 && std::string(argv[1]) == "--precision-harness") {
+		std::vector<precision_variant> variants = precision_cpu_variants();
+		for (precision_variant const& variant : scene.precision_variants())
+			variants.push_back(variant);
+		// early and late in a 64 s dispersion epoch, after a day, and on an epoch boundary (86400 = 1350 epochs)
+		int const failures = precision_harness_run(variants, { 64, 256, 2048 }, { 1, 7 }, { 0.5, 63.9, 86399.9, 86400.0, 86400.25 }, argc > 2 ? argv[2] : "");
+		glfwDestroyWindow(scene.window.glfw_window);
+		glfwTerminate();
+		return failures == 0 ? 0 : 1;
+	}
 
 
 	// ************************ //
@@ -67,7 +151,7 @@ int main(int, char* argv[])
 	//  (This call is different when we compile in standard mode with GLFW, than when we compile with emscripten to output the result in a webpage.)
 #ifndef __EMSCRIPTEN__
 	// Default mode to run the animation/display loop with GLFW in C++
-	while (!glfwWindowShouldClose(scene.window.glfw_window)) {
+	while (!glfwWindowShouldClose(scene.window.glfw_window) && !scene.flight.finished()) {
 		animation_loop();
 	}
 #else
@@ -76,13 +160,16 @@ int main(int, char* argv[])
 #endif
 
 	std::cout << "\nAnimation loop stopped" << std::endl;
+	bool const flight_completed = scene.flight.finished() && scene.flight.write_report(scene.benchmark_configuration());
 
 	// Cleanup
+	scene.readback.cleanup();
+	scene.heightfield_publisher.close();
 	cgp::imgui_cleanup();
 	glfwDestroyWindow(scene.window.glfw_window);
 	glfwTerminate();
 
-	return 0;
+	return scene.flight.enabled && !flight_completed ? 1 : 0;
 }
 
 void animation_loop()
@@ -110,7 +197,7 @@ void animation_loop()
 	ImGui::GetIO().FontGlobalScale = project::gui_scale;
 	ImGui::Begin("GUI", NULL, ImGuiWindowFlags_AlwaysAutoResize);
 	scene.inputs.mouse.on_gui = ImGui::GetIO().WantCaptureMouse;
-	scene.inputs.time_interval = time_interval;
+	scene.inputs.time_interval = scene.flight.enabled ? scene.flight.time_step : time_interval; // fixed step in the benchmark
 
 
 	// Display the ImGUI interface (button, sliders, etc)
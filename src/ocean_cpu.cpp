@@ -0,0 +1,337 @@
+#include "ocean_cpu.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+
+static const float g = 9.81f;             // gravity
+static const float PI_F = 3.14159265359f;
+static const double TWO_PI = 6.283185307179586;
+static const float l = 1.5f;              // small waves cutoff (same as spectrum_0.comp.glsl)
+
+// Same as philips() in spectrum_0.comp.glsl
+static float philips(float kx, float kz, float wind_x, float wind_z, float amplitude)
+{
+	float const V = std::sqrt(wind_x*wind_x + wind_z*wind_z);
+	float const Lp = V*V / g;
+	float const k_length = std::sqrt(kx*kx + kz*kz);
+	if (k_length == 0.f || V == 0.f) return 0.f;
+	float const k = std::max(k_length, 0.1f);
+
+	float const cos_wind = (kx*wind_x + kz*wind_z) / (k_length * V);
+	float const p = std::sqrt(amplitude * cos_wind*cos_wind * std::exp(-1.f/((k*Lp)*(k*Lp))) * std::exp(-(k*l)*(k*l))) / (k*k);
+	return std::min(std::max(p, 0.f), 4000.f);
+}
+
+// Wave vector of pixel (x,y) (centered, as in the compute shaders)
+static inline void wave_vector(int x, int y, int N, int ocean_size, float& kx, float& kz)
+{
+	int const half = N >> 1;
+	kx = 2.f * PI_F * float((x + half) % N - half) / ocean_size;
+	kz = 2.f * PI_F * float((y + half) % N - half) / ocean_size;
+}
+
+void ocean_cpu_structure::initialize(ocean_cpu_parameters const& parameters_arg, int num_threads)
+{
+	parameters = parameters_arg;
+	int const N = parameters.resolution;
+	size_t const size = size_t(N) * N;
+
+	// parallelism comes from the task graph, not from the FFT itself
+	fft_plan.initialize(N, 1, 1);
+	if (scheduler.queues.empty() || (num_threads > 0 && num_threads != scheduler.num_threads))
+		scheduler.initialize(num_threads);
+
+	spectrum_0.assign(size, complex_f(0.f));
+	for (auto& set : spectra) {
+		for (int k = 0; k < OCEAN_CPU_FIELDS; ++k)
+			set.field(k)->assign(size, complex_f(0.f));
+		set.valid = false;
+	}
+	current = 0;
+	foam_time = -1.0;
+	for (auto& row : graphs)
+		for (auto& graph : row) graph.clear();
+	dispersion.initialize(N, parameters.ocean_size);
+	displacement.assign(4 * size, 0.f);
+	normal.assign(4 * size, 0.f);
+
+	int const M = parameters.band_resolution;
+	size_t const band_size = size_t(M) * M;
+	if (M > 0) band_plan.initialize(M, 1, 1);
+	for (int k = 0; k < OCEAN_CPU_FIELDS; ++k)
+		band_spectra.field(k)->assign(band_size, complex_f(0.f));
+	band_displacement.assign(4 * band_size, 0.f);
+	band_normal.assign(4 * band_size, 0.f);
+
+	initial_spectrum();
+}
+
+void ocean_cpu_structure::initial_spectrum()
+{
+	int const N = parameters.resolution;
+
+	// random dist generation
+	std::mt19937 rng(parameters.seed);
+	std::normal_distribution<float> dist(0.f, 1.f); //~N(0,1)
+
+	for (int y = 0; y < N; ++y) {
+		for (int x = 0; x < N; ++x) {
+			float kx, kz;
+			wave_vector(x, y, N, parameters.ocean_size, kx, kz);
+			complex_f const E(dist(rng), dist(rng));
+			float const vp = philips(kx, kz, parameters.wind_x, parameters.wind_z, parameters.amplitude) / std::sqrt(2.f);
+			spectrum_0[size_t(y)*N + x] = E * vp;
+		}
+	}
+	for (auto& set : spectra) set.valid = false;
+}
+
+void ocean_cpu_structure::spectrum_update(ocean_cpu_spectra& spectra_out, double time, float choppiness, bool derivatives, int row_begin, int row_end) const
+{
+	int const N = parameters.resolution;
+	// phase(k) + omega(k) t in double, wrapped before the float sin/cos: in float, its rounding grows with the local time
+	//  (up to ~5e-6 relative error on the maps late in an epoch, where the shaders stay)
+	double const local_time = time - dispersion.epoch;
+	for (int y = row_begin; y < row_end; ++y) {
+		for (int x = 0; x < N; ++x) {
+			size_t const i = size_t(y)*N + x;
+			float kx, kz;
+			wave_vector(x, y, N, parameters.ocean_size, kx, kz);
+			float k = std::sqrt(kx*kx + kz*kz);
+			double const p = double(dispersion.phase[i]) + double(dispersion.omega[i]) * local_time;
+			float const phase = float(p - TWO_PI * std::floor(p * (1.0 / TWO_PI)));
+			complex_f const e(std::cos(phase), std::sin(phase));
+
+			// conj(h_0(-k)), wrapped on the first row/column: the spectra stay hermitian (real fields)
+			complex_f const h0 = spectrum_0[i];
+			complex_f const h0_est = std::conj(spectrum_0[size_t((N - y) % N)*N + (N - x) % N]);
+
+			complex_f const ht = complex_prod(h0, e) + complex_prod(h0_est, std::conj(e));
+			complex_f const iht(-ht.imag(), ht.real());
+			k = std::max(k, 0.1f);
+
+			complex_f const dx = -(iht * kx) / k * choppiness;
+			complex_f const dz = -(iht * kz) / k * choppiness;
+
+			spectra_out.h[i] = ht;
+			spectra_out.nx[i] = iht * kx;
+			spectra_out.nz[i] = iht * kz;
+			spectra_out.dx[i] = dx;
+			spectra_out.dz[i] = dz;
+
+			// foam: two real transforms for one, A + i B with B = i k D, i.e. A - k D
+			//  not on the Nyquist row/column: k has the same sign for k and -k there, B would leak into the real part
+			if (derivatives && x != N / 2 && y != N / 2) {
+				spectra_out.h[i] -= kz * dx;
+				spectra_out.dx[i] -= kx * dx;
+				spectra_out.dz[i] -= kz * dz;
+			}
+		}
+	}
+}
+
+// Same as normal.comp.glsl; the accumulated foam is read from `previous` (the previous maps, possibly `displacement` itself)
+static void pack_maps(ocean_cpu_spectra const& spectra_in, int N, float* displacement, float* normal, float const* previous, int row_begin, int row_end,
+	ocean_foam_parameters const& foam, float decay)
+{
+	if (previous == nullptr) decay = 0.f;
+	float const s = foam.jacobian_scale;
+	for (int y = row_begin; y < row_end; ++y) {
+		for (int x = 0; x < N; ++x) {
+			size_t const i = size_t(y)*N + x;
+			float* d = &displacement[4*i];
+			float* n = &normal[4*i];
+
+			float const jxx = s * spectra_in.dx[i].imag(), jzz = s * spectra_in.dz[i].imag(), jxz = s * spectra_in.h[i].imag();
+			float const jacobian = (1.f + jxx) * (1.f + jzz) - jxz * jxz;
+			float const coverage = s > 0.f ? std::min(std::max((foam.threshold - jacobian) * foam.gain, 0.f), 1.f) : 0.f;
+			float const kept = decay > 0.f ? previous[4*i + 3] * decay : 0.f; // caller-owned buffers may hold anything the first time
+
+			d[0] = spectra_in.dx[i].real(); d[1] = spectra_in.h[i].real(); d[2] = spectra_in.dz[i].real(); d[3] = std::max(coverage, kept);
+			n[0] = spectra_in.nx[i].real(); n[1] = 0.f;                    n[2] = spectra_in.nz[i].real(); n[3] = 1.f;
+		}
+	}
+}
+
+void ocean_cpu_structure::normal_update(ocean_cpu_spectra& spectra_in, int row_begin, int row_end)
+{
+	if (targets.displacement != nullptr)
+		pack_maps(spectra_in, parameters.resolution, targets.displacement, targets.normal, targets.previous, row_begin, row_end, foam, foam_decay);
+	else
+		pack_maps(spectra_in, parameters.resolution, displacement.data(), normal.data(), displacement.data(), row_begin, row_end, foam, foam_decay);
+}
+
+void ocean_cpu_structure::band_extract(ocean_cpu_spectra const& spectra_in, int row_begin, int row_end)
+{
+	// same as spectrum_band.comp.glsl: texel of the same wave vector, Nyquist row/column of the band dropped
+	int const N = parameters.resolution, M = parameters.band_resolution;
+	int const half = M >> 1;
+	for (int y = row_begin; y < row_end; ++y) {
+		int const wy = (y + half) % M - half;
+		for (int x = 0; x < M; ++x) {
+			int const wx = (x + half) % M - half;
+			bool const nyquist = wx == -half || wy == -half;
+			size_t const source = size_t((wy + N) % N) * N + (wx + N) % N;
+			size_t const i = size_t(y)*M + x;
+			for (int k = 0; k < OCEAN_CPU_FIELDS; ++k)
+				(*band_spectra.field(k))[i] = nyquist ? complex_f(0.f) : (*spectra_in.field(k))[source];
+		}
+	}
+}
+
+void ocean_cpu_structure::band_normal_update(int row_begin, int row_end)
+{
+	pack_maps(band_spectra, parameters.band_resolution, band_displacement.data(), band_normal.data(), band_displacement.data(), row_begin, row_end, foam, foam_decay);
+}
+
+// Add `chunks` tasks covering [0, size) to the graph, each depending on `after` (if >= 0); returns a barrier joining them
+template <typename F>
+static int add_chunk_tasks(task_graph_structure& graph, std::string const& name, int size, int chunks, int after, F const& fn)
+{
+	chunks = std::max(1, std::min(chunks, size));
+	int const barrier = graph.add_barrier(name + " done");
+	for (int c = 0; c < chunks; ++c) {
+		int const begin = (size * c) / chunks, end = (size * (c + 1)) / chunks;
+		int const task = graph.add_task(name, [fn, begin, end]() { fn(begin, end); });
+		if (after >= 0) graph.add_dependency(after, task);
+		graph.add_dependency(task, barrier);
+	}
+	return barrier;
+}
+
+void ocean_cpu_structure::build_graph(task_graph_structure& graph, bool spectrum, bool ahead)
+{
+	// tasks read the frame state (frame_time, next_time, choppiness, current) when they run: the graph is built once
+	int const N = parameters.resolution;
+	int const chunks = 2 * scheduler.num_threads;
+	graph.clear();
+
+	// spectrum of this frame, unless it was computed ahead during the previous update
+	int spectrum_done = -1;
+	if (spectrum) {
+		spectrum_done = add_chunk_tasks(graph, "spectrum", N, chunks, -1, [this](int b, int e) {
+			spectrum_update(spectra[current], frame.time, frame.choppiness, frame.derivatives, b, e);
+		});
+	}
+
+	// central band: copied before the full FFTs transform the spectra in place, then transformed alongside them
+	int const M = parameters.band_resolution;
+	int fields_ready = spectrum_done;
+	if (M > 0) {
+		fields_ready = add_chunk_tasks(graph, "band", M, chunks, spectrum_done, [this](int b, int e) { band_extract(spectra[current], b, e); });
+		int const band_maps = graph.add_barrier("band fft done");
+		for (int k = 0; k < OCEAN_CPU_FIELDS; ++k) {
+			complex_f* data = band_spectra.field(k)->data();
+			int after = fields_ready;
+			for (int pass = 0; pass < band_plan.num_passes(); ++pass) {
+				after = add_chunk_tasks(graph, "band fft " + std::to_string(k) + " pass " + std::to_string(pass), band_plan.pass_size(pass), chunks, after,
+					[this, data, pass](int b, int e) { band_plan.run_pass(pass, data, b, e); });
+			}
+			graph.add_dependency(after, band_maps);
+		}
+		add_chunk_tasks(graph, "band maps", M, chunks, band_maps, [this](int b, int e) { band_normal_update(b, e); });
+	}
+
+	// the five fields are independent: their passes interleave on the workers
+	int const maps = graph.add_barrier("fft done");
+	for (int k = 0; k < OCEAN_CPU_FIELDS; ++k) {
+		int after = fields_ready;
+		for (int pass = 0; pass < fft_plan.num_passes(); ++pass) {
+			after = add_chunk_tasks(graph, "fft " + std::to_string(k) + " pass " + std::to_string(pass), fft_plan.pass_size(pass), chunks, after,
+				[this, k, pass](int b, int e) { fft_plan.run_pass(pass, spectra[current].field(k)->data(), b, e); });
+		}
+		graph.add_dependency(after, maps);
+	}
+	add_chunk_tasks(graph, "maps", N, chunks, maps, [this](int b, int e) { normal_update(spectra[current], b, e); });
+
+	// next frame's spectrum overlaps this frame's FFTs and maps
+	if (ahead) {
+		add_chunk_tasks(graph, "spectrum (next)", N, chunks, -1, [this](int b, int e) {
+			spectrum_update(spectra[1 - current], frame.next_time, frame.choppiness, frame.derivatives, b, e);
+		});
+	}
+}
+
+double ocean_cpu_structure::update(double time, float choppiness, double next_time)
+{
+	auto const start = std::chrono::steady_clock::now();
+
+	// not while tasks read the phases; a spectrum computed ahead stays valid (same omega(k) t, other origin)
+	dispersion.update(time);
+
+	ocean_cpu_spectra& now = spectra[current];
+	bool const derivatives = foam.enabled();
+	bool const spectrum = !(now.valid && std::abs(now.time - time) <= prediction_tolerance && now.choppiness == choppiness && now.derivatives == derivatives);
+	if (!spectrum) time = now.time;
+
+	// foam of the previous maps fades over the time between the two updates
+	bool const accumulated = foam_time >= 0.0 && foam.lifetime > 0.f;
+	foam_decay = accumulated ? float(std::exp(-std::max(time - foam_time, 0.0) / foam.lifetime)) : 0.f;
+	foam_time = time;
+
+	ocean_cpu_spectra& next = spectra[1 - current];
+	bool const ahead = pipelined && next_time >= 0.0;
+	frame.time = time;
+	frame.next_time = next_time;
+	frame.choppiness = choppiness;
+	frame.derivatives = derivatives;
+
+	task_graph_structure& graph = graphs[spectrum][ahead];
+	if (graph.size() == 0) build_graph(graph, spectrum, ahead);
+	scheduler.run(graph);
+
+	now.valid = false; // transformed in place
+	if (ahead) {
+		next.time = next_time;
+		next.choppiness = choppiness;
+		next.derivatives = derivatives;
+		next.valid = true;
+		current = 1 - current;
+	}
+
+	last_update_ms = float(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	return time;
+}
+
+// BENCHMARK
+void ocean_cpu_benchmark(int resolution, int frames)
+{
+	ocean_cpu_parameters parameters;
+	parameters.resolution = resolution;
+	parameters.wind_x = parameters.wind_z = 28.f;
+
+	struct configuration { char const* name; int threads; bool pipelined; };
+	int const hardware = std::max(1, int(std::thread::hardware_concurrency()));
+	configuration const configurations[] = {
+		{ "serial", 1, false },
+		{ "task graph", hardware, false },
+		{ "task graph + pipelined spectrum", hardware, true },
+	};
+
+	std::cout << "[CPU engine benchmark] " << resolution << "x" << resolution << ", " << frames << " frames" << std::endl;
+	for (auto const& c : configurations) {
+		ocean_cpu_structure ocean;
+		ocean.pipelined = c.pipelined;
+		ocean.initialize(parameters, c.threads);
+
+		// fixed time step: the next frame time is known exactly
+		double const dt = 1.0 / 60.0;
+		double total = 0.0;
+		std::map<std::string, double> task_time;
+		for (int f = 0; f <= frames; ++f) {
+			ocean.update(f * dt, 1.5f, (f + 1) * dt);
+			if (f == 0) continue; // warm up (and no spectrum computed ahead yet)
+			total += ocean.last_update_ms;
+			for (auto const& t : ocean.scheduler.last_run_timings) {
+				std::string const& name = *t.name;
+				task_time[name.substr(0, name.find(" pass"))] += t.end - t.start;
+			}
+		}
+		std::cout << "  " << c.name << " (" << c.threads << " threads): " << total / frames << " ms per frame" << std::endl;
+		for (auto const& t : task_time)
+			if (t.second > 0.0) std::cout << "      " << t.first << ": " << t.second / frames << " ms" << std::endl;
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "dispersion.hpp"
+#include "fft_cpu.hpp"
+#include "task_graph.hpp"
+
+#include <vector>
+
+// CPU version of the ocean computation (spectrum_0, spectrum_t, FFTs and normal.comp.glsl)
+//  Used instead of the compute shaders for resolutions >= CPU_ENGINE_THRESHOLD
+//  Outputs have the same layout as the displacement/normal layers of maps_image: RGBA float, unnormalized (divided by N^2 in ocean.vert.glsl)
+//  A frame is a task graph: spectrum -> 5 independent 2D FFTs (pass by pass) -> maps,
+//  and the spectrum of the next frame (other buffer set) runs concurrently with the FFTs of the current one.
+//  The graphs are built on the first update and reused: a steady state update does not allocate.
+
+#define CPU_ENGINE_THRESHOLD 4096
+#define OCEAN_CPU_FIELDS 5
+
+struct ocean_cpu_parameters {
+	int resolution = 256;     // N (must be 2^k)
+	int ocean_size = 512;     // L
+	float amplitude = 40.f;
+	float wind_x = 0.f, wind_z = 0.f;
+	unsigned int seed = 0;
+	int band_resolution = 0;  // M < N: the central band of the spectrum is also transformed at M x M (0: no band)
+};
+
+// Foam: coverage where the Jacobian of the horizontal displacement drops below `threshold`, kept with an exponential decay
+//  The derivatives ride in the imaginary parts of the h, Dx and Dz transforms (the fields are real): no extra FFT
+//  Without foam they are not packed at all (the spectra are the same as before foam)
+struct ocean_foam_parameters {
+	float jacobian_scale = 0.f; // derivatives of the unnormalized maps to tile units (0: no foam)
+	bool enabled() const { return jacobian_scale > 0.f; }
+	float threshold = 0.6f;     // no foam above (J = 1: flat water, J < 0: folded)
+	float gain = 2.f;           // coverage per unit of J below the threshold
+	float lifetime = 2.f;       // decay time of the accumulated foam (s)
+};
+
+// Time varying spectra, transformed in place (same order as the layers of spectrum_fields)
+struct ocean_cpu_spectra {
+	std::vector<complex_f> h, dx, nx, dz, nz; // h + i dDx/dz, Dx + i dDx/dx, Dz + i dDz/dz once transformed
+	double time = 0.0;
+	float choppiness = 0.f;
+	bool derivatives = false; // the Jacobian derivatives are packed in the imaginary parts (foam)
+	bool valid = false; // holds the spectrum of (time, choppiness, derivatives), not transformed yet
+
+	std::vector<complex_f>* field(int k) { std::vector<complex_f>* f[] = { &h, &dx, &nx, &dz, &nz }; return f[k]; }
+	std::vector<complex_f> const* field(int k) const { return const_cast<ocean_cpu_spectra*>(this)->field(k); }
+};
+
+// Caller-owned destination of the maps (N*N*4 floats each), instead of displacement/normal (embedding library)
+struct ocean_cpu_targets {
+	float* displacement = nullptr;   // nullptr: the engine's own vectors
+	float* normal = nullptr;
+	float const* previous = nullptr; // displacement of the previous maps (accumulated foam), may be `displacement`; nullptr: none
+};
+
+struct ocean_cpu_structure {
+	ocean_cpu_parameters parameters;
+	fft_cpu_structure fft_plan;
+	task_scheduler_structure scheduler;
+	task_graph_structure graphs[2][2]; // [spectrum of the frame computed][next spectrum computed ahead], built on first use
+
+	// state of the running update, read by the tasks
+	struct {
+		double time = 0.0, next_time = -1.0;
+		float choppiness = 0.f;
+		bool derivatives = false;
+	} frame;
+
+	// initial spectrum h_0(k) and phases omega(k) t
+	std::vector<complex_f> spectrum_0;
+	dispersion_structure dispersion;
+
+	// spectra[current] is used by the next update, the other one is computed ahead when pipelined
+	ocean_cpu_spectra spectra[2];
+	int current = 0;
+	bool pipelined = true;
+	float prediction_tolerance = 0.f; // accept a spectrum computed ahead up to this time difference (s)
+
+	// results (RGBA)
+	std::vector<float> displacement; // (Dx, h, Dz, foam)
+	std::vector<float> normal;       // (nx, 0, nz, 1)
+	ocean_cpu_targets targets;
+
+	// band-limited maps of the central band (same layout, unnormalized like the full maps), for distant tiles
+	fft_cpu_structure band_plan;
+	ocean_cpu_spectra band_spectra;
+	std::vector<float> band_displacement;
+	std::vector<float> band_normal;
+
+	ocean_foam_parameters foam;
+	double foam_time = -1.0;         // time of the maps holding the accumulated foam
+	float foam_decay = 0.f;          // decay of the accumulated foam since foam_time (set by update)
+
+	float last_update_ms = 0.f;      // latency of the last update
+
+	void initialize(ocean_cpu_parameters const& parameters_arg, int num_threads = 0);
+	void initial_spectrum();         // h_0(k) from the Philips spectrum and a gaussian noise
+
+	// Compute the maps at `time`; if next_time >= 0 the spectrum of next_time is computed during the FFTs
+	//  Returns the simulation time of the maps (a spectrum computed ahead is accepted within prediction_tolerance)
+	double update(double time, float choppiness, double next_time = -1.0);
+
+	void build_graph(task_graph_structure& graph, bool spectrum, bool ahead);
+
+	// Stages on a range of rows (tasks of the graph)
+	void spectrum_update(ocean_cpu_spectra& spectra_out, double time, float choppiness, bool derivatives, int row_begin, int row_end) const; // h(k,t), D(k,t), n(k,t)
+	void normal_update(ocean_cpu_spectra& spectra_in, int row_begin, int row_end);                                      // pack the results in displacement/normal (or targets)
+	void band_extract(ocean_cpu_spectra const& spectra_in, int row_begin, int row_end);                                 // rows of the band, before the full FFTs
+	void band_normal_update(int row_begin, int row_end);                                                               // pack the band results
+};
+
+// Latency of the serial engine vs the task graph (with and without pipelining), with per-task timings
+void ocean_cpu_benchmark(int resolution, int frames);
@@ -0,0 +1,359 @@
+#include "precision_harness.hpp"
+
+#include "ocean_cpu.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+
+using complex_d = std::complex<double>;
+
+static const double g = 9.81;
+static const double TWO_PI = 6.283185307179586;
+
+// REFERENCE TRANSFORMS
+static void dft_1d(complex_d* x, int n, size_t stride, std::vector<complex_d> const& w, std::vector<complex_d>& work)
+{
+	for (int k = 0; k < n; ++k) {
+		complex_d sum = 0.0;
+		for (int j = 0; j < n; ++j)
+			sum += x[j * stride] * w[(size_t(j) * k) % n];
+		work[k] = sum;
+	}
+	for (int k = 0; k < n; ++k) x[k * stride] = work[k];
+}
+
+void precision_dft_2d(std::vector<complex_d>& data, int N)
+{
+	std::vector<complex_d> w(N), work(N);
+	for (int k = 0; k < N; ++k) w[k] = std::polar(1.0, TWO_PI * k / N);
+	for (int y = 0; y < N; ++y) dft_1d(&data[size_t(y) * N], N, 1, w, work);
+	for (int x = 0; x < N; ++x) dft_1d(&data[x], N, N, w, work);
+}
+
+static void fft_1d(complex_d* x, int n, size_t stride, std::vector<complex_d> const& w, std::vector<complex_d>& work)
+{
+	for (int k = 0; k < n; ++k) work[k] = x[k * stride];
+
+	// bit reversal, then iterative butterflies; w[k] = exp(2 i pi k / n) computed directly (no accumulated rotation)
+	for (int i = 1, j = 0; i < n; ++i) {
+		int bit = n >> 1;
+		for (; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if (i < j) std::swap(work[i], work[j]);
+	}
+	for (int len = 2; len <= n; len <<= 1) {
+		int const step = n / len;
+		for (int i = 0; i < n; i += len) {
+			for (int k = 0; k < len / 2; ++k) {
+				complex_d const a = work[i + k], b = work[i + k + len / 2] * w[size_t(k) * step];
+				work[i + k] = a + b;
+				work[i + k + len / 2] = a - b;
+			}
+		}
+	}
+	for (int k = 0; k < n; ++k) x[k * stride] = work[k];
+}
+
+void precision_fft_2d(std::vector<complex_d>& data, int N)
+{
+	std::vector<complex_d> w(N), work(N);
+	for (int k = 0; k < N; ++k) w[k] = std::polar(1.0, TWO_PI * k / N);
+	for (int y = 0; y < N; ++y) fft_1d(&data[size_t(y) * N], N, 1, w, work);
+	for (int x = 0; x < N; ++x) fft_1d(&data[x], N, N, w, work);
+}
+
+
+// REFERENCE PIPELINE
+void precision_reference(precision_case const& c, std::vector<complex_f> const& spectrum_0, int resolution, precision_output& out)
+{
+	auto const start = std::chrono::steady_clock::now();
+	int const N = c.resolution, M = resolution;
+	int const half = N >> 1, band_half = M >> 1;
+
+	// h, Dx, nx, Dz, nz at M x M: the whole spectrum (M = N) or its central band
+	std::vector<complex_d> fields[5];
+	for (auto& f : fields) f.assign(size_t(M) * M, 0.0);
+	for (int y = 0; y < M; ++y) {
+		int const wy = (y + band_half) % M - band_half;
+		for (int x = 0; x < M; ++x) {
+			int const wx = (x + band_half) % M - band_half;
+			if (M < N && (wx == -band_half || wy == -band_half)) continue; // dropped by the band
+			int const sx = (wx + N) % N, sy = (wy + N) % N;
+			size_t const i = size_t(sy) * N + sx;
+
+			double const kx = TWO_PI * ((sx + half) % N - half) / c.ocean_size;
+			double const kz = TWO_PI * ((sy + half) % N - half) / c.ocean_size;
+			double const k = std::sqrt(kx*kx + kz*kz);
+			// the engines' dispersion is the float omega (dispersion.cpp), its product with t is exact here
+			double const omega = double(float(std::sqrt(g * k)));
+			double const phase = std::fmod(omega * c.time, TWO_PI);
+			complex_d const e = std::polar(1.0, phase);
+
+			complex_d const h0(spectrum_0[i].real(), spectrum_0[i].imag());
+			complex_f const h0_opposite = spectrum_0[size_t((N - sy) % N) * N + (N - sx) % N];
+			complex_d const h0_est = std::conj(complex_d(h0_opposite.real(), h0_opposite.imag()));
+
+			complex_d const h = h0 * e + h0_est * std::conj(e);
+			complex_d const ih = complex_d(0.0, 1.0) * h;
+			double const k_clamped = std::max(k, double(0.1f));
+			size_t const j = size_t(y) * M + x;
+			fields[0][j] = h;
+			fields[1][j] = -ih * kx / k_clamped * double(c.choppiness);
+			fields[2][j] = ih * kx;
+			fields[3][j] = -ih * kz / k_clamped * double(c.choppiness);
+			fields[4][j] = ih * kz;
+		}
+	}
+	for (auto& f : fields) precision_fft_2d(f, M);
+
+	out.resolution = M;
+	out.displacement.assign(4 * size_t(M) * M, 0.f);
+	out.normal.assign(4 * size_t(M) * M, 0.f);
+	for (size_t j = 0; j < size_t(M) * M; ++j) {
+		out.displacement[4*j + 0] = float(fields[1][j].real());
+		out.displacement[4*j + 1] = float(fields[0][j].real());
+		out.displacement[4*j + 2] = float(fields[3][j].real());
+		out.normal[4*j + 0] = float(fields[2][j].real());
+		out.normal[4*j + 2] = float(fields[4][j].real());
+	}
+	out.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+precision_errors precision_compare(precision_output const& reference, precision_output const& variant)
+{
+	// channel (map, component) of each value of the three groups
+	struct channel { int group; bool normal; int component; };
+	channel const channels[] = { { 0, false, 1 }, { 1, false, 0 }, { 1, false, 2 }, { 2, true, 0 }, { 2, true, 2 } };
+
+	double error_max[3] = {}, error_sum[3] = {}, reference_max[3] = {}, reference_sum[3] = {};
+	size_t const size = size_t(reference.resolution) * reference.resolution;
+	for (channel const& ch : channels) {
+		std::vector<float> const& r = ch.normal ? reference.normal : reference.displacement;
+		std::vector<float> const& v = ch.normal ? variant.normal : variant.displacement;
+		for (size_t i = 0; i < size; ++i) {
+			double const a = r[4*i + ch.component], e = double(v[4*i + ch.component]) - a;
+			error_max[ch.group] = std::max(error_max[ch.group], std::abs(e));
+			error_sum[ch.group] += e * e;
+			reference_max[ch.group] = std::max(reference_max[ch.group], std::abs(a));
+			reference_sum[ch.group] += a * a;
+		}
+	}
+
+	precision_errors errors;
+	for (int k = 0; k < 3; ++k) {
+		errors.max[k] = reference_max[k] > 0.0 ? error_max[k] / reference_max[k] : error_max[k];
+		errors.rms[k] = reference_sum[k] > 0.0 ? std::sqrt(error_sum[k] / reference_sum[k]) : std::sqrt(error_sum[k]);
+	}
+	return errors;
+}
+
+
+// CPU ENGINE VARIANTS
+static ocean_cpu_parameters engine_parameters(precision_case const& c)
+{
+	ocean_cpu_parameters parameters;
+	parameters.resolution = c.resolution;
+	parameters.ocean_size = c.ocean_size;
+	parameters.amplitude = c.amplitude;
+	parameters.wind_x = c.wind_x;
+	parameters.wind_z = c.wind_z;
+	parameters.seed = c.seed;
+	return parameters;
+}
+
+static void engine_output(std::vector<float> const& displacement, std::vector<float> const& normal, int resolution, double ms, precision_output& out)
+{
+	out.resolution = resolution;
+	out.displacement = displacement;
+	out.normal = normal;
+	out.ms = ms;
+}
+
+std::vector<precision_variant> precision_cpu_variants()
+{
+	std::vector<precision_variant> variants;
+
+	precision_variant engine;
+	engine.name = "cpu engine";
+	engine.max_resolution = FFT_SIX_STEP_THRESHOLD - 1;
+	engine.budget_max = 5e-6;
+	engine.budget_rms = 1e-6;
+	engine.run = [](precision_case const& c, std::vector<complex_f> const& spectrum_0, precision_output& out) {
+		ocean_cpu_structure ocean;
+		ocean.pipelined = false;
+		ocean.initialize(engine_parameters(c));
+		ocean.spectrum_0 = spectrum_0;
+		ocean.update(c.time, c.choppiness);
+		engine_output(ocean.displacement, ocean.normal, c.resolution, ocean.last_update_ms, out);
+		return true;
+	};
+	variants.push_back(engine);
+
+	precision_variant six_step = engine;
+	six_step.name = "cpu engine six-step";
+	six_step.max_resolution = 1 << 30;
+	six_step.run = [engine](precision_case const& c, std::vector<complex_f> const& spectrum_0, precision_output& out) {
+		return c.resolution >= FFT_SIX_STEP_THRESHOLD && engine.run(c, spectrum_0, out);
+	};
+	variants.push_back(six_step);
+
+	// spectrum computed ahead during the previous update, then consumed
+	precision_variant pipelined = engine;
+	pipelined.name = "cpu engine pipelined";
+	pipelined.run = [](precision_case const& c, std::vector<complex_f> const& spectrum_0, precision_output& out) {
+		ocean_cpu_structure ocean;
+		ocean.pipelined = true;
+		ocean.initialize(engine_parameters(c));
+		ocean.spectrum_0 = spectrum_0;
+		ocean.update(c.time - 1.0 / 60.0, c.choppiness, c.time);
+		ocean.update(c.time, c.choppiness);
+		engine_output(ocean.displacement, ocean.normal, c.resolution, ocean.last_update_ms, out);
+		return true;
+	};
+	variants.push_back(pipelined);
+
+	precision_variant band = engine;
+	band.name = "cpu engine band";
+	band.run = [](precision_case const& c, std::vector<complex_f> const& spectrum_0, precision_output& out) {
+		ocean_cpu_parameters parameters = engine_parameters(c);
+		parameters.band_resolution = c.resolution / 4;
+		if (parameters.band_resolution < 16) return false;
+		ocean_cpu_structure ocean;
+		ocean.pipelined = false;
+		ocean.initialize(parameters);
+		ocean.spectrum_0 = spectrum_0;
+		ocean.update(c.time, c.choppiness);
+		engine_output(ocean.band_displacement, ocean.band_normal, parameters.band_resolution, ocean.last_update_ms, out);
+		return true;
+	};
+	variants.push_back(band);
+
+	return variants;
+}
+
+
+// HARNESS
+static bool reference_selftest()
+{
+	// the radix-2 reference against the naive DFT on random data
+	int const N = 64;
+	std::mt19937 rng(1);
+	std::normal_distribution<double> dist(0.0, 1.0);
+	std::vector<complex_d> a(size_t(N) * N);
+	for (auto& v : a) v = complex_d(dist(rng), dist(rng));
+	std::vector<complex_d> b = a;
+	precision_dft_2d(a, N);
+	precision_fft_2d(b, N);
+
+	double error = 0.0, magnitude = 0.0;
+	for (size_t i = 0; i < a.size(); ++i) {
+		error = std::max(error, std::abs(a[i] - b[i]));
+		magnitude = std::max(magnitude, std::abs(a[i]));
+	}
+	std::cout << "[precision] reference FFT vs naive DFT (" << N << "x" << N << "): max error " << std::scientific << std::setprecision(2)
+		<< error / magnitude << std::defaultfloat << std::setprecision(6) << std::endl;
+	return error / magnitude < 1e-12;
+}
+
+int precision_harness_run(std::vector<precision_variant> const& variants, std::vector<int> const& resolutions,
+	std::vector<unsigned int> const& seeds, std::vector<double> const& times, std::string const& report_path)
+{
+	if (!reference_selftest()) {
+		std::cout << "[precision] the reference itself is wrong" << std::endl;
+		return -1;
+	}
+
+	std::ofstream csv;
+	if (!report_path.empty()) {
+		csv.open(report_path);
+		if (!csv) std::cout << "[precision] cannot write " << report_path << std::endl;
+		csv << "variant,resolution,map_resolution,seed,time,height_max,height_rms,displacement_max,displacement_rms,slope_max,slope_rms,ms,reference_ms,budget_max,budget_rms,pass\n";
+	}
+
+	// worst errors and time of each variant, for the summary
+	struct summary { double max = 0.0, rms = 0.0; std::map<int, double> ms; std::map<int, int> runs; int failures = 0; };
+	std::map<std::string, summary> summaries;
+
+	std::cout << "[precision] errors relative to the reference: max |e| / max |ref|, RMS e / RMS ref" << std::endl;
+	std::cout << std::left << std::setw(26) << "variant" << std::right << std::setw(10) << "N (maps)" << std::setw(6) << "seed" << std::setw(11) << "time"
+		<< std::setw(20) << "height max/rms" << std::setw(20) << "displ. max/rms" << std::setw(20) << "slope max/rms" << std::setw(11) << "ms" << "  result" << std::endl;
+
+	int failures = 0;
+	for (int N : resolutions) {
+		for (unsigned int seed : seeds) {
+			// the initial spectrum of the CPU engine, shared by the reference and every variant
+			ocean_cpu_structure spectrum;
+			precision_case c;
+			c.resolution = N;
+			c.seed = seed;
+			spectrum.parameters = engine_parameters(c);
+			spectrum.spectrum_0.resize(size_t(N) * N);
+			spectrum.initial_spectrum();
+
+			for (double time : times) {
+				c.time = time;
+				std::map<int, precision_output> references; // by map resolution (full or band)
+				for (precision_variant const& variant : variants) {
+					if (N > variant.max_resolution) continue;
+					precision_output out;
+					if (!variant.run(c, spectrum.spectrum_0, out)) continue;
+
+					precision_output& reference = references[out.resolution];
+					if (reference.resolution == 0) precision_reference(c, spectrum.spectrum_0, out.resolution, reference);
+					precision_errors const e = precision_compare(reference, out);
+
+					bool pass = true;
+					for (int k = 0; k < 3; ++k)
+						pass = pass && e.max[k] <= variant.budget_max && e.rms[k] <= variant.budget_rms;
+					failures += pass ? 0 : 1;
+
+					summary& s = summaries[variant.name];
+					for (int k = 0; k < 3; ++k) {
+						s.max = std::max(s.max, e.max[k]);
+						s.rms = std::max(s.rms, e.rms[k]);
+					}
+					s.ms[N] += out.ms;
+					s.runs[N] += 1;
+					s.failures += pass ? 0 : 1;
+
+					std::ostringstream pairs[3];
+					for (int k = 0; k < 3; ++k)
+						pairs[k] << std::scientific << std::setprecision(1) << e.max[k] << "/" << e.rms[k];
+					std::string const resolution = std::to_string(N) + (out.resolution != N ? "/" + std::to_string(out.resolution) : "");
+					std::cout << std::left << std::setw(26) << variant.name << std::right << std::setw(10) << resolution << std::setw(6) << seed
+						<< std::setw(11) << std::fixed << std::setprecision(2) << time << std::defaultfloat;
+					for (int k = 0; k < 3; ++k) std::cout << std::setw(20) << pairs[k].str();
+					std::cout << std::setw(11) << std::fixed << std::setprecision(2) << out.ms << std::defaultfloat << std::setprecision(6)
+						<< "  " << (pass ? "ok" : "FAIL") << std::endl;
+
+					if (csv.is_open()) {
+						csv << variant.name << "," << N << "," << out.resolution << "," << seed << "," << std::setprecision(10) << time << std::setprecision(6);
+						for (int k = 0; k < 3; ++k) csv << "," << e.max[k] << "," << e.rms[k];
+						csv << "," << out.ms << "," << reference.ms << "," << variant.budget_max << "," << variant.budget_rms << "," << (pass ? 1 : 0) << "\n";
+					}
+				}
+			}
+		}
+	}
+
+	// speed versus accuracy
+	std::cout << "[precision] summary (worst relative errors, mean time per resolution):" << std::endl;
+	for (precision_variant const& variant : variants) {
+		auto const found = summaries.find(variant.name);
+		if (found == summaries.end()) continue;
+		summary const& s = found->second;
+		std::cout << "  " << variant.name << ": max " << std::scientific << std::setprecision(1) << s.max << " (budget " << variant.budget_max
+			<< "), RMS " << s.rms << " (budget " << variant.budget_rms << ")" << std::defaultfloat << std::setprecision(4);
+		for (auto const& m : s.ms) std::cout << ", " << m.first << ": " << m.second / s.runs.at(m.first) << " ms";
+		std::cout << (s.failures ? ", FAILED" : "") << std::setprecision(6) << std::endl;
+	}
+	std::cout << "[precision] " << failures << " comparison(s) over budget" << std::endl;
+	return failures;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "fft_cpu.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Precision and regression harness (--precision-harness): every engine variant against a double precision reference
+//  - reference: h(k,t), D(k,t), n(k,t) evaluated in double from the same h_0(k) (float, shared by all variants),
+//    then a double radix-2 FFT (itself checked against a naive DFT); omega(k) is the float of the engines, omega t is exact
+//  - per variant, resolution, seed and time: max and RMS error of height (h), displacement (Dx, Dz) and slope (nx, nz),
+//    relative to the max / RMS of the reference, and the time the variant took
+//  - a variant fails when an error exceeds its budget; new variants (packed, half precision, fused...) only add a precision_variant
+
+struct precision_case {
+	int resolution = 256;
+	unsigned int seed = 1;
+	double time = 0.0;
+	float choppiness = 1.5f;
+	int ocean_size = 512;
+	float amplitude = 40.f;
+	float wind_x = 28.28f, wind_z = 28.28f;
+};
+
+// Maps of a variant, same layout as maps_image: displacement (Dx, h, Dz, *), normal (nx, *, nz, *)
+struct precision_output {
+	int resolution = 0; // lower than the case resolution: central band of the spectrum (Nyquist row/column dropped)
+	std::vector<float> displacement, normal;
+	double ms = 0.0;
+};
+
+struct precision_variant {
+	std::string name;
+	int max_resolution = 1 << 30;
+	double budget_max = 1e-4;  // max error / max |reference|
+	double budget_rms = 1e-5;  // RMS error / RMS reference
+	// false: the variant does not apply to this case (skipped)
+	std::function<bool(precision_case const&, std::vector<complex_f> const& spectrum_0, precision_output&)> run;
+};
+
+struct precision_errors {
+	double max[3] = {}, rms[3] = {}; // height, displacement, slope
+};
+
+// Double precision transforms (same convention as fft_cpu: unnormalized, exponent sign +1), N x N row-major in place
+void precision_dft_2d(std::vector<std::complex<double>>& data, int N); // naive, O(N^3) separable
+void precision_fft_2d(std::vector<std::complex<double>>& data, int N); // radix-2, exact twiddles
+
+// Reference maps of a case at `resolution` (the case resolution or the central band of it)
+void precision_reference(precision_case const& c, std::vector<complex_f> const& spectrum_0, int resolution, precision_output& out);
+precision_errors precision_compare(precision_output const& reference, precision_output const& variant);
+
+// CPU engine variants (task graph, pipelined spectrum, six-step above FFT_SIX_STEP_THRESHOLD, band)
+std::vector<precision_variant> precision_cpu_variants();
+
+// Run every variant on resolutions x seeds x times, print the table (and write it as CSV if report_path is not empty)
+//  Returns the number of failed comparisons (-1 if the reference itself is wrong)
+int precision_harness_run(std::vector<precision_variant> const& variants, std::vector<int> const& resolutions,
+	std::vector<unsigned int> const& seeds, std::vector<double> const& times, std::string const& report_path);
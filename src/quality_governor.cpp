@@ -0,0 +1,219 @@
+#include "quality_governor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+void quality_governor_structure::initialize(quality_settings const& settings_arg)
+{
+	settings = settings_arg;
+	frame = 0;
+	frame_average = load_average = simulation_average = render_average = 0.f;
+	frames_over = frames_under = 0;
+	cooldown = cooldown_frames; // startup frames (compilation, first spectrum) are not representative
+	log.clear();
+}
+
+double quality_governor_structure::simulation_cost(quality_settings const& s)
+{
+	// FFTs: N^2 log2 N, spread over the simulation period
+	double const N = s.resolution;
+	return N * N * std::log2(std::max(N, 2.0)) / std::max(s.update_period, 1);
+}
+
+double quality_governor_structure::render_cost(quality_settings const& s)
+{
+	// vertices: a low quality tile has a quarter of the vertices of a high quality one
+	double cost = 0.0;
+	int const half = s.num_patches / 2;
+	for (int i = -half; i <= half; ++i)
+		for (int j = -half; j <= half; ++j)
+			cost += std::max(std::abs(i), std::abs(j)) >= s.lq_ring ? 1.0 : 4.0;
+	return cost;
+}
+
+float quality_governor_structure::predicted_load(quality_settings const& s) const
+{
+	double const simulation = simulation_average * simulation_cost(s) / simulation_cost(settings);
+	double const render = render_average * render_cost(s) / render_cost(settings);
+	return float(load_average + (simulation - simulation_average) + (render - render_average));
+}
+
+void quality_governor_structure::apply(quality_settings const& s, char const* knob, int before, int after, char const* reason)
+{
+	std::ostringstream line;
+	line.setf(std::ios::fixed);
+	line.precision(1);
+	line << "[quality] frame " << frame << ": " << knob << " " << before << " -> " << after << " (" << reason
+		<< ": load " << load_average << " ms, frame " << frame_average << " ms, target " << target_ms
+		<< " ms, simulation " << simulation_average << " ms, render " << render_average << " ms)";
+	log.push_back(line.str());
+	if (verbose) std::cout << line.str() << std::endl;
+
+	settings = s;
+	cooldown = cooldown_frames;
+	frames_over = frames_under = 0;
+}
+
+bool quality_governor_structure::degrade()
+{
+	// cheapest visual loss first, on the stage that costs the most
+	quality_settings s = settings;
+	bool const simulation_bound = simulation_average >= render_average;
+	for (int step = 0; step < 4; ++step) {
+		int const knob = simulation_bound ? step : (step + 2) % 4;
+		s = settings;
+		if (knob == 0 && s.update_period < max_update_period) {
+			++s.update_period;
+			apply(s, "update period", settings.update_period, s.update_period, "over budget");
+			return true;
+		}
+		if (knob == 1 && s.resolution / 2 >= min_resolution) {
+			s.resolution /= 2;
+			apply(s, "resolution", settings.resolution, s.resolution, "over budget");
+			return true;
+		}
+		if (knob == 2 && s.lq_ring > min_lq_ring) {
+			--s.lq_ring;
+			apply(s, "lq ring", settings.lq_ring, s.lq_ring, "over budget");
+			return true;
+		}
+		if (knob == 3 && s.num_patches - 2 >= min_patches) {
+			s.num_patches -= 2;
+			apply(s, "patches", settings.num_patches, s.num_patches, "over budget");
+			return true;
+		}
+	}
+	return false;
+}
+
+bool quality_governor_structure::upgrade()
+{
+	// most visible quality first, only if the prediction stays under the lower margin
+	float const limit = target_ms * (1.f - hysteresis);
+	quality_settings s;
+
+	s = settings; s.resolution *= 2;
+	if (s.resolution <= max_resolution && predicted_load(s) < limit) {
+		apply(s, "resolution", settings.resolution, s.resolution, "headroom");
+		return true;
+	}
+	s = settings; s.num_patches += 2;
+	if (s.num_patches <= max_patches && predicted_load(s) < limit) {
+		apply(s, "patches", settings.num_patches, s.num_patches, "headroom");
+		return true;
+	}
+	s = settings; s.lq_ring += 1;
+	if (s.lq_ring <= max_lq_ring && predicted_load(s) < limit) {
+		apply(s, "lq ring", settings.lq_ring, s.lq_ring, "headroom");
+		return true;
+	}
+	s = settings; s.update_period -= 1;
+	if (s.update_period >= 1 && predicted_load(s) < limit) {
+		apply(s, "update period", settings.update_period, s.update_period, "headroom");
+		return true;
+	}
+	return false;
+}
+
+bool quality_governor_structure::update(quality_timings const& timings)
+{
+	++frame;
+	float const load = std::max(timings.cpu_ms, timings.simulation_ms + timings.render_ms);
+	auto average = [](float& a, float v) { a = a == 0.f ? v : 0.9f * a + 0.1f * v; };
+	average(frame_average, timings.frame_ms);
+	average(load_average, load);
+	average(simulation_average, timings.simulation_ms);
+	average(render_average, timings.render_ms);
+
+	if (!enabled) return false;
+	if (cooldown > 0) {
+		--cooldown;
+		return false;
+	}
+
+	// the frame time is pinned by vsync when under budget: headroom is measured on the load
+	float const high = target_ms * (1.f + hysteresis), low = target_ms * (1.f - hysteresis);
+	frames_over = (frame_average > high || load_average > high) ? frames_over + 1 : 0;
+	frames_under = (load_average < low && frame_average < high) ? frames_under + 1 : 0;
+
+	if (frames_over >= hysteresis_frames) {
+		frames_over = 0;
+		return degrade();
+	}
+	if (frames_under >= hysteresis_frames) {
+		frames_under = 0;
+		return upgrade();
+	}
+	return false;
+}
+
+
+// TRACES
+void quality_trace_header(std::ostream& out)
+{
+	out << "# frame_ms cpu_ms simulation_ms render_ms resolution num_patches lq_ring update_period" << std::endl;
+}
+
+void quality_trace_line(std::ostream& out, quality_timings const& t, quality_settings const& s)
+{
+	out << t.frame_ms << " " << t.cpu_ms << " " << t.simulation_ms << " " << t.render_ms << " "
+		<< s.resolution << " " << s.num_patches << " " << s.lq_ring << " " << s.update_period << "\n";
+}
+
+int quality_governor_replay(std::string const& trace_path, float target_ms, quality_governor_structure governor)
+{
+	std::ifstream in(trace_path);
+	if (!in) {
+		std::cout << "[quality] cannot read " << trace_path << std::endl;
+		return -1;
+	}
+
+	struct record { quality_timings timings; quality_settings settings; };
+	std::vector<record> records;
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.empty() || line[0] == '#') continue;
+		std::istringstream fields(line);
+		record r;
+		fields >> r.timings.frame_ms >> r.timings.cpu_ms >> r.timings.simulation_ms >> r.timings.render_ms
+			>> r.settings.resolution >> r.settings.num_patches >> r.settings.lq_ring >> r.settings.update_period;
+		if (fields) records.push_back(r);
+	}
+	if (records.empty()) {
+		std::cout << "[quality] empty trace " << trace_path << std::endl;
+		return -1;
+	}
+
+	governor.target_ms = target_ms;
+	governor.max_resolution = std::max(governor.max_resolution, records[0].settings.resolution);
+	governor.max_patches = std::max(governor.max_patches, records[0].settings.num_patches);
+	governor.initialize(records[0].settings);
+
+	// open loop on the recording, closed loop through the cost model: timings are rescaled to the current settings
+	float const high = target_ms * (1.f + governor.hysteresis);
+	int over_recorded = 0, over_replayed = 0;
+	for (record const& r : records) {
+		quality_timings t = r.timings;
+		float const load = std::max(t.cpu_ms, t.simulation_ms + t.render_ms);
+		t.simulation_ms = float(t.simulation_ms * quality_governor_structure::simulation_cost(governor.settings) / quality_governor_structure::simulation_cost(r.settings));
+		t.render_ms = float(t.render_ms * quality_governor_structure::render_cost(governor.settings) / quality_governor_structure::render_cost(r.settings));
+		t.cpu_ms = std::max(0.f, t.cpu_ms + (t.simulation_ms - r.timings.simulation_ms));
+		float const replayed_load = std::max(t.cpu_ms, t.simulation_ms + t.render_ms);
+		// frames that waited for vsync only get longer once the load exceeds them
+		t.frame_ms = t.frame_ms > target_ms ? std::max(0.f, t.frame_ms + (replayed_load - load)) : std::max(t.frame_ms, replayed_load);
+
+		over_recorded += r.timings.frame_ms > high ? 1 : 0;
+		over_replayed += t.frame_ms > high ? 1 : 0;
+		governor.update(t);
+	}
+
+	quality_settings const& s = governor.settings;
+	std::cout << "[quality] " << records.size() << " frames, " << governor.log.size() << " adjustments; frames over budget: "
+		<< 100.0 * over_recorded / records.size() << "% recorded, " << 100.0 * over_replayed / records.size() << "% with the governor" << std::endl;
+	std::cout << "[quality] final settings: resolution " << s.resolution << ", patches " << s.num_patches
+		<< ", lq ring " << s.lq_ring << ", update period " << s.update_period << std::endl;
+	return int(governor.log.size());
+}
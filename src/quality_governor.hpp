@@ -0,0 +1,71 @@
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Adaptive quality: holds a target frame time by moving one quality knob at a time
+//  - per-stage timings are averaged every frame
+//  - over budget during hysteresis_frames: degrades a knob of the most expensive stage
+//  - under budget: upgrades only if the cost model predicts the frame stays under budget (no oscillation)
+//  - after a change, the timings settle during cooldown_frames before the next decision
+//  Every adjustment is logged. No OpenGL dependency: recorded traces can be replayed offline (quality_governor_replay).
+
+struct quality_settings {
+	int resolution = 256;   // simulation resolution (2^k)
+	int num_patches = 5;    // tiles per side (odd)
+	int lq_ring = 2;        // tiles at a ring distance >= lq_ring from the camera tile use the low quality mesh
+	int update_period = 1;  // simulation period of the nearest band in frames (temporal LOD pressure + 1)
+};
+
+struct quality_timings {
+	float frame_ms = 0.f;       // frame to frame
+	float cpu_ms = 0.f;         // CPU work of the frame (without the wait for vsync)
+	float simulation_ms = 0.f;  // simulation (GPU or CPU engine), 0 on frames without keyframe
+	float render_ms = 0.f;      // GPU drawing of the tiles
+};
+
+struct quality_governor_structure {
+	bool enabled = true;
+	float target_ms = 16.7f;
+	float hysteresis = 0.15f;      // relative margin around the target
+	int hysteresis_frames = 30;    // consecutive frames outside the margin before acting
+	int cooldown_frames = 60;      // frames ignored after a change
+	bool verbose = true;           // print the adjustments
+
+	// bounds of the knobs
+	int min_resolution = 64, max_resolution = 256;
+	int min_patches = 3, max_patches = 5;
+	int min_lq_ring = 1, max_lq_ring = 3;
+	int max_update_period = 4;
+
+	quality_settings settings;
+
+	// state
+	long long frame = 0;
+	float frame_average = 0.f, load_average = 0.f, simulation_average = 0.f, render_average = 0.f;
+	int frames_over = 0, frames_under = 0, cooldown = 0;
+	std::vector<std::string> log;
+
+	void initialize(quality_settings const& settings_arg);
+	// Returns true if the settings changed
+	bool update(quality_timings const& timings);
+
+	// Relative costs of the stages, used to predict upgrades and to replay traces recorded with other settings
+	static double simulation_cost(quality_settings const& s);
+	static double render_cost(quality_settings const& s);
+
+	// internal
+	bool degrade();
+	bool upgrade();
+	float predicted_load(quality_settings const& s) const;
+	void apply(quality_settings const& s, char const* knob, int before, int after, char const* reason);
+};
+
+// Trace: one line per frame "frame_ms cpu_ms simulation_ms render_ms resolution num_patches lq_ring update_period"
+void quality_trace_header(std::ostream& out);
+void quality_trace_line(std::ostream& out, quality_timings const& timings, quality_settings const& settings);
+
+// Feed a recorded trace to a governor; stage timings are rescaled by the cost model to the governor's settings
+//  Prints every adjustment and a summary; returns the number of adjustments (-1 if the trace cannot be read)
+int quality_governor_replay(std::string const& trace_path, float target_ms, quality_governor_structure governor = quality_governor_structure());
@@ -0,0 +1,315 @@
+#include "readback_ring.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+static bool buffer_storage_supported()
+{
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if (major > 4 || (major == 4 && minor >= 4)) return true;
+
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint k = 0; k < count; ++k) {
+		char const* name = reinterpret_cast<char const*>(glGetStringi(GL_EXTENSIONS, k));
+		if (name != nullptr && std::strcmp(name, "GL_ARB_buffer_storage") == 0) return true;
+	}
+	return false;
+}
+
+bool readback_ring_structure::initialize(int num_slots, int max_width_arg, int max_height_arg, int max_layers_arg)
+{
+	cleanup();
+	max_width = max_width_arg;
+	max_height = max_height_arg;
+	max_layers = max_layers_arg;
+	slot_bytes = size_t(max_width) * max_height * max_layers * 4 * sizeof(float);
+	persistent = buffer_storage_supported();
+
+	GLbitfield const flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	slots.resize(std::max(num_slots, 2));
+	for (slot_structure& slot : slots) {
+		glGenBuffers(1, &slot.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		if (persistent) {
+			glBufferStorage(GL_PIXEL_PACK_BUFFER, GLsizeiptr(slot_bytes), nullptr, flags);
+			slot.mapped = static_cast<float*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(slot_bytes), flags));
+		}
+		else {
+			glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(slot_bytes), nullptr, GL_STREAM_READ);
+			slot.copy.resize(slot_bytes / sizeof(float));
+		}
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (persistent && std::any_of(slots.begin(), slots.end(), [](slot_structure const& s) { return s.mapped == nullptr; })) {
+		std::cout << "[readback] persistent mapping failed" << std::endl;
+		cleanup();
+		return false;
+	}
+
+	glGenFramebuffers(1, &read_fbo);
+	glGenFramebuffers(1, &scratch_fbo);
+	requested = completed = dropped = 0;
+	return true;
+}
+
+void readback_ring_structure::cleanup()
+{
+	for (slot_structure& slot : slots) {
+		if (slot.fence != nullptr) glDeleteSync(slot.fence);
+		if (slot.mapped != nullptr) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glDeleteBuffers(1, &slot.pbo);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slots.clear();
+
+	if (read_fbo != 0) glDeleteFramebuffers(1, &read_fbo);
+	if (scratch_fbo != 0) glDeleteFramebuffers(1, &scratch_fbo);
+	if (scratch_texture != 0) glDeleteTextures(1, &scratch_texture);
+	read_fbo = scratch_fbo = scratch_texture = 0;
+}
+
+bool readback_ring_structure::request(GLuint texture_array, int texture_width, int texture_height, std::vector<int> const& layers, readback_region const& region, long long frame, double time)
+{
+	++requested;
+
+	int const x = std::max(0, std::min(region.x, texture_width - 1));
+	int const y = std::max(0, std::min(region.y, texture_height - 1));
+	int const width = std::min(region.width > 0 ? region.width : texture_width, texture_width - x);
+	int const height = std::min(region.height > 0 ? region.height : texture_height, texture_height - y);
+	int const step = std::max(1, region.step);
+	int const w = std::max(1, width / step), h = std::max(1, height / step);
+	if (w > max_width || h > max_height || int(layers.size()) > max_layers || layers.empty()) {
+		++dropped;
+		return false;
+	}
+
+	// a free slot, else the oldest completed one that is not the latest (consumers may still ask for it)
+	int index = -1;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		long long latest = -1;
+		for (slot_structure const& slot : slots)
+			if (slot.state == slot_ready || slot.state == slot_held) latest = std::max(latest, slot.frame.frame);
+		for (int k = 0; k < int(slots.size()); ++k) {
+			slot_structure const& slot = slots[k];
+			if (slot.state == slot_free) { index = k; break; }
+			if (slot.state == slot_ready && slot.frame.frame != latest && (index < 0 || slot.frame.frame < slots[index].frame.frame))
+				index = k;
+		}
+		if (index < 0) {
+			++dropped;
+			return false;
+		}
+		slot_structure& slot = slots[index];
+		slot.state = slot_pending;
+		slot.frame.slot = index;
+		slot.frame.frame = frame;
+		slot.frame.time = time;
+		slot.frame.width = w;
+		slot.frame.height = h;
+		slot.frame.layers = int(layers.size());
+		slot.frame.data = nullptr;
+	}
+	slot_structure& slot = slots[index];
+
+	GLint previous_read = 0, previous_draw = 0;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_draw);
+
+	// downsampling goes through a scratch texture (blit with nearest filtering)
+	if (step > 1) {
+		GLint scratch_width = 0, scratch_height = 0;
+		if (scratch_texture != 0) {
+			glBindTexture(GL_TEXTURE_2D, scratch_texture);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &scratch_width);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &scratch_height);
+		}
+		if (scratch_width < w || scratch_height < h) {
+			if (scratch_texture != 0) glDeleteTextures(1, &scratch_texture);
+			glGenTextures(1, &scratch_texture);
+			glBindTexture(GL_TEXTURE_2D, scratch_texture);
+			glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, w, h);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, scratch_fbo);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, scratch_texture, 0);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	for (int k = 0; k < int(layers.size()); ++k) {
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, read_fbo);
+		glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture_array, 0, layers[k]);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+		GLvoid* offset = reinterpret_cast<GLvoid*>(size_t(k) * w * h * 4 * sizeof(float));
+		if (step == 1) {
+			glReadPixels(x, y, w, h, GL_RGBA, GL_FLOAT, offset);
+		}
+		else {
+			glBlitFramebuffer(x, y, x + w * step, y + h * step, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, scratch_fbo);
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+			glReadPixels(0, 0, w, h, GL_RGBA, GL_FLOAT, offset);
+		}
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, GLuint(previous_read));
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, GLuint(previous_draw));
+	return true;
+}
+
+void readback_ring_structure::poll()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (slot_structure& slot : slots) {
+		if (slot.state != slot_pending) continue;
+		// timeout 0: never waits (the flush makes sure the fence is eventually signaled)
+		GLenum const status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+
+		size_t const bytes = size_t(slot.frame.width) * slot.frame.height * slot.frame.layers * 4 * sizeof(float);
+		if (persistent) {
+			slot.frame.data = slot.mapped;
+		}
+		else {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+			void const* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(bytes), GL_MAP_READ_BIT);
+			if (data != nullptr) {
+				std::memcpy(slot.copy.data(), data, bytes);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			slot.frame.data = slot.copy.data();
+		}
+		slot.state = slot_ready;
+		++completed;
+	}
+}
+
+bool readback_ring_structure::acquire_latest(readback_frame& frame, long long newer_than)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	int best = -1;
+	for (int k = 0; k < int(slots.size()); ++k) {
+		slot_structure const& slot = slots[k];
+		if ((slot.state == slot_ready || slot.state == slot_held) && slot.frame.frame > newer_than
+			&& (best < 0 || slot.frame.frame > slots[best].frame.frame))
+			best = k;
+	}
+	if (best < 0) return false;
+
+	slot_structure& slot = slots[best];
+	slot.state = slot_held;
+	slot.holders++;
+	frame = slot.frame;
+	return true;
+}
+
+void readback_ring_structure::release(readback_frame const& frame)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (frame.slot < 0 || frame.slot >= int(slots.size())) return;
+	slot_structure& slot = slots[frame.slot];
+	if (slot.state == slot_held && --slot.holders == 0) slot.state = slot_ready;
+}
+
+
+// SELF TEST
+int readback_ring_selftest()
+{
+	int const N = 64, L = 2;
+
+	// each texel holds its coordinates (x, y, layer, 1)
+	std::vector<float> pattern(size_t(N) * N * L * 4);
+	for (int l = 0; l < L; ++l)
+		for (int y = 0; y < N; ++y)
+			for (int x = 0; x < N; ++x) {
+				float* p = &pattern[4 * ((size_t(l) * N + y) * N + x)];
+				p[0] = float(x); p[1] = float(y); p[2] = float(l); p[3] = 1.f;
+			}
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA32F, N, N, L);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, N, N, L, GL_RGBA, GL_FLOAT, pattern.data());
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	readback_ring_structure ring;
+	if (!ring.initialize(3, N, N, L)) return 1;
+	std::cout << "[readback] " << ring.slots.size() << " slots, persistent mapping: " << (ring.persistent ? "yes" : "no (copy on poll)") << std::endl;
+
+	struct test_case { char const* name; readback_region region; };
+	test_case cases[4];
+	cases[0].name = "whole map";
+	cases[1].name = "region of interest"; cases[1].region.x = 8; cases[1].region.y = 16; cases[1].region.width = 32; cases[1].region.height = 16;
+	cases[2].name = "downsampled x4"; cases[2].region.step = 4;
+	cases[3].name = "region downsampled x2"; cases[3].region.x = 4; cases[3].region.y = 8; cases[3].region.width = 40; cases[3].region.height = 32; cases[3].region.step = 2;
+
+	int errors = 0;
+	long long id = 0;
+	for (test_case const& c : cases) {
+		++id;
+		if (!ring.request(texture, N, N, { 0, 1 }, c.region, id, 0.0)) {
+			std::cout << "[readback] " << c.name << ": request dropped" << std::endl;
+			++errors;
+			continue;
+		}
+
+		// the render thread would keep going: only poll
+		readback_frame frame;
+		int polls = 0;
+		auto const start = std::chrono::steady_clock::now();
+		while (!ring.acquire_latest(frame, id - 1)) {
+			ring.poll();
+			++polls;
+			if (std::chrono::steady_clock::now() - start > std::chrono::seconds(5)) break;
+		}
+		if (frame.frame != id) {
+			std::cout << "[readback] " << c.name << ": not completed" << std::endl;
+			++errors;
+			continue;
+		}
+
+		// texel (i, j) of the result comes from the block [x + i*step, x + (i+1)*step) x [y + j*step, ...)
+		int const step = std::max(1, c.region.step);
+		int wrong = 0;
+		for (int l = 0; l < frame.layers; ++l)
+			for (int j = 0; j < frame.height; ++j)
+				for (int i = 0; i < frame.width; ++i) {
+					float const* p = frame.layer(l) + 4 * (size_t(j) * frame.width + i);
+					int const x0 = c.region.x + i * step, y0 = c.region.y + j * step;
+					bool const ok = p[0] >= x0 && p[0] < x0 + step && p[1] >= y0 && p[1] < y0 + step && p[2] == float(l) && p[3] == 1.f;
+					wrong += ok ? 0 : 1;
+				}
+		std::cout << "[readback] " << c.name << ": " << frame.width << "x" << frame.height << "x" << frame.layers << " after " << polls << " non-blocking polls, " << wrong << " wrong texels" << std::endl;
+		errors += wrong;
+		ring.release(frame);
+	}
+
+	// more requests than slots without polling: the extra ones are dropped, nothing waits
+	long long const dropped_before = ring.dropped;
+	int accepted = 0;
+	for (int k = 0; k < 6; ++k)
+		accepted += ring.request(texture, N, N, { 0 }, readback_region(), ++id, 0.0) ? 1 : 0;
+	std::cout << "[readback] burst of 6 requests: " << accepted << " queued, " << (ring.dropped - dropped_before) << " dropped" << std::endl;
+	if (accepted == 0 || accepted > int(ring.slots.size())) ++errors;
+
+	ring.cleanup();
+	glDeleteTextures(1, &texture);
+	std::cout << "[readback] " << (errors == 0 ? "passed" : "FAILED") << std::endl;
+	return errors;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+
+#include <mutex>
+#include <vector>
+
+// Asynchronous readback of texture array layers (displacement/normal maps) to host memory
+//  - request() only queues GPU commands: an optional downsampling blit of the region, glReadPixels into a PBO, a fence
+//  - poll() checks the fences without waiting; acquire_latest() returns the newest completed request (frame N-k) or nothing
+//  - the PBOs are persistently mapped (GL_ARB_buffer_storage): consumers read the data in place, from any thread, until release()
+//  - without buffer storage, poll() maps completed PBOs once and copies them to host memory
+//  A request is dropped (never waited for) when every slot is in flight or held by a consumer.
+
+struct readback_region {
+	int x = 0, y = 0;          // region of interest (texels)
+	int width = 0, height = 0; // 0: up to the border of the texture
+	int step = 1;              // downsampling factor (nearest texel)
+};
+
+struct readback_frame {
+	int slot = -1;
+	long long frame = 0;                    // id given to request()
+	double time = 0.0;
+	int width = 0, height = 0, layers = 0;  // after downsampling
+	float const* data = nullptr;            // RGBA float rows, layers one after another
+
+	float const* layer(int k) const { return data + size_t(k) * width * height * 4; }
+};
+
+struct readback_ring_structure {
+	enum slot_state { slot_free, slot_pending, slot_ready, slot_held };
+	struct slot_structure {
+		GLuint pbo = 0;
+		GLsync fence = nullptr;
+		float* mapped = nullptr;      // persistent mapping
+		std::vector<float> copy;      // fallback without buffer storage
+		slot_state state = slot_free;
+		int holders = 0;
+		readback_frame frame;
+	};
+
+	std::vector<slot_structure> slots;
+	bool persistent = false;
+	size_t slot_bytes = 0;
+	int max_width = 0, max_height = 0, max_layers = 0;
+
+	// downsampling: source layer -> scratch texture
+	GLuint read_fbo = 0, scratch_fbo = 0, scratch_texture = 0;
+
+	// statistics
+	long long requested = 0, completed = 0, dropped = 0;
+
+	// GL thread
+	bool initialize(int num_slots, int max_width_arg, int max_height_arg, int max_layers_arg);
+	void cleanup();
+	bool is_initialized() const { return !slots.empty(); }
+	bool request(GLuint texture_array, int texture_width, int texture_height, std::vector<int> const& layers, readback_region const& region, long long frame, double time);
+	void poll();
+
+	// any thread
+	bool acquire_latest(readback_frame& frame, long long newer_than = -1);
+	void release(readback_frame const& frame);
+
+	size_t bytes() const { return slots.size() * slot_bytes; }
+
+	std::mutex mutex;
+};
+
+// Reads back known patterns (whole map, region of interest, downsampled) without ever blocking; returns the number of errors
+//  Needs a current GL context (e.g. LIBGL_ALWAYS_SOFTWARE=1 for a software driver)
+int readback_ring_selftest();
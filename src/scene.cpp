@@ -1,10 +1,14 @@
 #include "scene.hpp"
+#include <chrono>
 #include <random>
+#include <sstream>
 
 using namespace cgp;
 
 #define RESOLUTION 256 // must be 2^k
 #define WORK_GROUP_DIM 16 // NE PAS CHANGER !!
+#define NUM_SPECTRUM_FIELDS 5 // h, Dx, nx, Dz, nz (layers of spectrum_fields, same order as the shaders)
+#define BAND_DIVISOR 4 // the distant tiles use the central band of the spectrum at resolution / BAND_DIVISOR
 
 const float PI = 3.14159265359f;
 
@@ -14,6 +18,7 @@ const float scale = 0.15;
 const int NUM_PATCHES = 5; // odd
 const float ocean_length = scale*ocean_size;
 const float ocean_height = -2.0;
+const int mesh_resolution = RESOLUTION < 256 ? RESOLUTION : 256; // grid of a patch (maps larger than 256 are only sampled)
 
 
 void scene_structure::initialize()
@@ -29,6 +34,7 @@ void scene_structure::initialize()
 	// COMPUTE SHADERS
 	spectrum_0.load(project::path + "shaders/compute_shaders/spectrum_0.comp.glsl");
 	spectrum_t.load(project::path + "shaders/compute_shaders/spectrum_t.comp.glsl");
+	spectrum_band.load(project::path + "shaders/compute_shaders/spectrum_band.comp.glsl");
 	fft_horizontal.load(project::path + "shaders/compute_shaders/fft_rows.comp.glsl");
 	fft_vertical.load(project::path + "shaders/compute_shaders/fft_columns.comp.glsl");
 	normal.load(project::path + "shaders/compute_shaders/normal.comp.glsl");
@@ -40,43 +46,64 @@ void scene_structure::initialize()
 		project::path + "shaders/ocean/ocean.frag.glsl"
 	);
 
+	// all programs compile concurrently (if the driver allows it), wait for them here
+	opengl_shader_finish_loading();
+
+	// above this resolution the ping-pong FFT is bandwidth bound: compute on CPU and upload the results
+	use_cpu_engine = RESOLUTION >= CPU_ENGINE_THRESHOLD;
+	spectrum_seed = flight.enabled ? flight.seed : std::random_device()();
+
+	// QUALITY (starts at the maximum, the governor lowers it if the frame budget is not met)
+	// the CPU engine and the shared memory consumers keep the resolution they started with
+	bool const fixed_resolution = use_cpu_engine || !project::shm_name.empty();
+	governor.min_resolution = fixed_resolution ? RESOLUTION : std::min(64, RESOLUTION);
+	governor.max_resolution = RESOLUTION;
+	governor.min_patches = std::min(3, NUM_PATCHES);
+	governor.max_patches = NUM_PATCHES;
+	governor.max_lq_ring = NUM_PATCHES/2 + 1; // no low quality tile
+	num_patches = NUM_PATCHES;
+	lq_ring = 2;
+	governor.initialize({ RESOLUTION, num_patches, lq_ring, 1 });
+	if (flight.enabled)
+		gui.quality_governor = false; // the benchmark compares fixed settings
+	if (!project::timings_trace_path.empty()) {
+		timings_trace.open(project::timings_trace_path);
+		quality_trace_header(timings_trace);
+	}
+
 	// TEXTURES
-	// initial spectrum
-	spectrum_0_image.initialize_texture_2d_on_gpu(RESOLUTION, RESOLUTION, GL_RGBA32F, GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST);
-	// displacements and normals in each direction 
-	dx_image.initialize_texture_2d_on_gpu(RESOLUTION, RESOLUTION, GL_RGBA32F, GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST);
-	dy_image.initialize_texture_2d_on_gpu(RESOLUTION, RESOLUTION, GL_RGBA32F, GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST);
-	dz_image.initialize_texture_2d_on_gpu(RESOLUTION, RESOLUTION, GL_RGBA32F, GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST);
-	// final textures
-	spectrum_t_image.initialize_texture_2d_on_gpu(RESOLUTION, RESOLUTION, GL_RGBA32F, GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST);
-	normal_image.initialize_texture_2d_on_gpu(RESOLUTION, RESOLUTION, GL_RGBA32F, GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST);
-	displacement_image.initialize_texture_2d_on_gpu(RESOLUTION, RESOLUTION, GL_RGBA32F, GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST);
-	// utility texture
-	temp_image.initialize_texture_2d_on_gpu(RESOLUTION, RESOLUTION, GL_RGBA32F, GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST);
+	allocate_simulation(RESOLUTION);
 	
 	// WATER MESH
 	// High Quality
-	mesh sea_grid = mesh_primitive_grid({ 0, ocean_height, 0 }, { ocean_length, ocean_height, 0 }, { ocean_length, ocean_height, ocean_length }, { 0, ocean_height, ocean_length }, RESOLUTION, RESOLUTION);
+	mesh sea_grid = mesh_primitive_grid({ 0, ocean_height, 0 }, { ocean_length, ocean_height, 0 }, { ocean_length, ocean_height, ocean_length }, { 0, ocean_height, ocean_length }, mesh_resolution, mesh_resolution);
 
 	water.initialize_data_on_gpu(sea_grid);
 	water.shader = ocean;
-	water.supplementary_texture["u_normal_map"] =  normal_image;
-	water.supplementary_texture["u_displacement_map"] = displacement_image;
+	water.supplementary_texture["u_maps"] = maps_image;
 	
 	// Low Quality
-	mesh sea_grid_lq = mesh_primitive_grid({ 0, ocean_height, 0 }, { ocean_length, ocean_height, 0 }, { ocean_length, ocean_height, ocean_length }, { 0, ocean_height, ocean_length }, RESOLUTION/2, RESOLUTION/2);
+	mesh sea_grid_lq = mesh_primitive_grid({ 0, ocean_height, 0 }, { ocean_length, ocean_height, 0 }, { ocean_length, ocean_height, ocean_length }, { 0, ocean_height, ocean_length }, mesh_resolution/2, mesh_resolution/2);
 
 	water_lq.initialize_data_on_gpu(sea_grid_lq);
 	water_lq.shader = ocean;
-	water_lq.supplementary_texture["u_normal_map"] =  normal_image;
-	water_lq.supplementary_texture["u_displacement_map"] = displacement_image;
+	water_lq.supplementary_texture["u_maps"] = band_resolution > 0 ? band_maps_image : maps_image;
 
 	// Patch location of neighbors
-	for(int i = -NUM_PATCHES/2; i <= NUM_PATCHES/2; ++i){
-		for(int j = -NUM_PATCHES/2; j <= NUM_PATCHES/2; ++j){
-			neighbors.push_back(vec3(i,0,j));
-		}
-	}
+	initialize_neighbors();
+
+	// SHARED MEMORY PUBLICATION
+	readback_roi.step = std::max(1, project::readback_step);
+	int const published_resolution = use_cpu_engine ? resolution : std::max(1, resolution / readback_roi.step);
+	if (!project::shm_name.empty() && heightfield_publisher.open(project::shm_name, published_resolution, published_resolution, 1.f / (RESOLUTION * RESOLUTION)))
+		std::cout << "Publishing the displacement map in shared memory " << project::shm_name << std::endl;
+
+	// GPU READBACK (the CPU engine results are already in host memory)
+	if (heightfield_publisher.is_open() && !use_cpu_engine)
+		readback.initialize(3, published_resolution, published_resolution, 2);
+
+	// TEMPORAL LOD
+	initialize_temporal_lod();
 
 	// SUN MESH
 	sun.initialize_data_on_gpu(mesh_primitive_sphere(5.0f));
@@ -85,66 +112,181 @@ void scene_structure::initialize()
 	sun.material.phong.diffuse = 0;
 	sun.material.phong.specular = 0;
 	 
-	// DEBUG MESH
+	// DEBUG MESH (textures are set when the frame is displayed)
 	mesh quad = mesh_primitive_quadrangle();
-	debug_z.initialize_data_on_gpu(quad, mesh_drawable::default_shader, displacement_image);
-	debug_y.initialize_data_on_gpu(quad.apply_rotation_to_position(vec3(1,0,0), PI/2.0f), mesh_drawable::default_shader, spectrum_t_image);
-	debug_x.initialize_data_on_gpu(quad.apply_rotation_to_position(vec3(0,0,1), PI/2.0f), mesh_drawable::default_shader, normal_image);
+	debug_z.initialize_data_on_gpu(quad, mesh_drawable::default_shader, displacement_view[0]);
+	debug_y.initialize_data_on_gpu(quad.apply_rotation_to_position(vec3(1,0,0), PI/2.0f), mesh_drawable::default_shader, displacement_view[0]);
+	debug_x.initialize_data_on_gpu(quad.apply_rotation_to_position(vec3(0,0,1), PI/2.0f), mesh_drawable::default_shader, normal_view[0]);
+
+	// SCRIPTED FLIGHT
+	if (flight.enabled && !flight.initialize(ocean_height))
+		flight.enabled = false;
 
-	debug_z.texture = displacement_image;
-	debug_y.texture = spectrum_t_image;
-	debug_x.texture = normal_image;
+	print_gpu_memory_report();
 } 
 
+void scene_structure::allocate_simulation(int resolution_arg)
+{
+	resolution = resolution_arg;
+
+	// spectra (only the GPU path needs them): complex values are RG, one layer per field
+	if (!use_cpu_engine) {
+		spectrum_0_image.release();
+		dispersion_image.release();
+		spectrum_fields.release();
+		spectrum_fields_temp.release();
+		spectrum_0_image.initialize_texture_2d_on_gpu(resolution, resolution, GL_RG32F, GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST);
+		dispersion.initialize(resolution, ocean_size);
+		dispersion_image.initialize_texture_2d_on_gpu(resolution, resolution, GL_RG32F, GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST, dispersion.texels.data());
+		spectrum_fields.initialize_texture_2d_array_on_gpu(resolution, resolution, NUM_SPECTRUM_FIELDS, GL_RG32F);
+		spectrum_fields_temp.initialize_texture_2d_array_on_gpu(resolution, resolution, NUM_SPECTRUM_FIELDS, GL_RG32F);
+	}
+	spectrum_t_image.release();
+
+	// final maps of the last two keyframes (temporal LOD)
+	for (int k = 0; k < 2; ++k) {
+		displacement_view[k].release();
+		normal_view[k].release();
+	}
+	maps_image.release();
+	maps_image.initialize_texture_2d_array_on_gpu(resolution, resolution, 4, GL_RGBA32F);
+	for (int k = 0; k < 2; ++k) {
+		displacement_view[k].initialize_texture_view(maps_image, 2*k);
+		normal_view[k].initialize_texture_view(maps_image, 2*k + 1);
+	}
+
+	// band-limited maps of the distant tiles, filtered linearly (nothing left to alias)
+	band_fields.release();
+	band_fields_temp.release();
+	band_maps_image.release();
+	band_resolution = std::max(resolution / BAND_DIVISOR, std::min(resolution, 2 * WORK_GROUP_DIM));
+	if (band_resolution < resolution) {
+		if (!use_cpu_engine) {
+			band_fields.initialize_texture_2d_array_on_gpu(band_resolution, band_resolution, NUM_SPECTRUM_FIELDS, GL_RG32F);
+			band_fields_temp.initialize_texture_2d_array_on_gpu(band_resolution, band_resolution, NUM_SPECTRUM_FIELDS, GL_RG32F);
+		}
+		band_maps_image.initialize_texture_2d_array_on_gpu(band_resolution, band_resolution, 4, GL_RGBA32F, GL_REPEAT, GL_REPEAT, GL_LINEAR, GL_LINEAR);
+	}
+	else
+		band_resolution = 0;
+
+	water.supplementary_texture["u_maps"] = maps_image;
+	water_lq.supplementary_texture["u_maps"] = band_resolution > 0 ? band_maps_image : maps_image;
+	foam_time = -1.0;
+}
+
+void scene_structure::initialize_temporal_lod()
+{
+	// bands of camera distance to the water: the farther, the longer the shortest visible wave
+	float const pixel_angle = camera_projection.field_of_view / std::max(window.height, 1);
+	float const k_max = PI * resolution / ocean_size; // Nyquist
+	std::vector<temporal_lod_band> bands;
+	for (vec2 band : { vec2(0, 1), vec2(20, 2), vec2(80, 4) }) { // (distance, base period)
+		temporal_lod_band b;
+		b.distance = band.x;
+		b.k_visible = temporal_lod_visible_wave_number(std::max(band.x, 1.f), pixel_angle, 1.f/scale, k_max);
+		b.base_period = int(band.y);
+		bands.push_back(b);
+	}
+	temporal_lod.initialize(bands);
+}
+
+void scene_structure::initialize_neighbors()
+{
+	neighbors.clear();
+	for(int i = -num_patches/2; i <= num_patches/2; ++i){
+		for(int j = -num_patches/2; j <= num_patches/2; ++j){
+			neighbors.push_back(vec3(i,0,j));
+		}
+	}
+}
+
+quality_settings scene_structure::current_quality() const
+{
+	return { resolution, num_patches, lq_ring, std::max(1, temporal_lod.pressure + 1) };
+}
+
+void scene_structure::apply_quality(quality_settings const& settings)
+{
+	if (settings.resolution != resolution) {
+		// same noise, other band: only the shortest waves appear or vanish
+		allocate_simulation(settings.resolution);
+		initialize_temporal_lod();
+		compute_initial_spectrum = true;
+	}
+	if (settings.num_patches != num_patches) {
+		num_patches = settings.num_patches;
+		initialize_neighbors();
+	}
+	lq_ring = settings.lq_ring;
+	temporal_lod.pressure = settings.update_period - 1;
+}
+
 void scene_structure::display_frame()
 {
+	auto const frame_start = std::chrono::steady_clock::now();
 	timer.update();
+	simulation_time += inputs.time_interval;
+	draw_calls = tiles_drawn = tiles_culled = tiles_lq = 0;
 
 	// when some gui parameters change (or at program start), we randomly generate the initial spectrum
 	if (compute_initial_spectrum)
 	{
 		initial_spectrum();
 		compute_initial_spectrum = false;
+		temporal_lod.invalidate();
+		governor.cooldown = governor.cooldown_frames; // this frame is not representative
 	}
 
-	// generate time varying spectrum from initial spectrum
-	spectrum_update();
-
-	// reorder spectrum texture (just for printing it in the screen, not necessary to generate the ocean)
-	texture_ordering(dy_image, spectrum_t_image);
-
-	// where the magic happpens :)
-	fft(fft_vertical, dy_image);
-	fft(fft_horizontal, dy_image);
-	fft(fft_horizontal, dx_image);
-	fft(fft_vertical, dx_image);
-	fft(fft_horizontal, dz_image);
-	fft(fft_vertical, dz_image);
+	vec3 player_position = camera_control.camera_model.position();
 
-	// save normal and displacement maps to textures
- 	normal_update();
-	
+	// simulate only on keyframes (temporal LOD), the maps are interpolated in between
+	temporal_lod.enabled = gui.temporal_lod;
+	temporal_lod.adaptive = !gui.quality_governor && !flight.enabled;
+	if (flight.enabled)
+		temporal_lod.pressure = flight.lod_pressure; // same keyframes on every machine and every run
+	temporal_lod.error_tolerance = gui.lod_error;
+	temporal_lod.frame_budget = gui.frame_budget_ms / 1000.f;
+	bool const keyframe = temporal_lod.begin_frame(simulation_time, inputs.time_interval, std::abs(player_position.y - ocean_height));
+	uint64_t simulation_section = 0;
+	if (keyframe)
+	{
+		if (!use_cpu_engine) simulation_timer.begin();
+		double const keyframe_time = simulate(temporal_lod.keyframe_time());
+		if (!use_cpu_engine) simulation_section = simulation_timer.end();
+		temporal_lod.set_keyframe_time(keyframe_time); // interpolate from the time the maps actually hold
+		publish_heightfield(keyframe_time);
+		++keyframe_count;
+	}
+	readback.poll();
+	poll_heightfield_readback();
 	
-	vec3 player_position = camera_control.camera_model.position();
 	
 	// DRAW SUN (+ day night cycle)
 	if(gui.dn_cycle){
-		float rad = NUM_PATCHES/2.0 * ocean_length;
-		sun.model.translation = vec3(player_position.x + rad*cos(timer.t*0.1), rad*sin(timer.t*0.1) - 20.0, player_position.z);
+		float rad = num_patches/2.0 * ocean_length;
+		float const sun_time = float(simulation_time); // fixed steps in the flight benchmark: same sun, same draws on every run
+		sun.model.translation = vec3(player_position.x + rad*cos(sun_time*0.1), rad*sin(sun_time*0.1) - 20.0, player_position.z);
 
 		environment.light = sun.model.translation;
-		environment.background_color = vec3(157.0,221.0,237.0)/256.0 * (std::max(0.1, sin(timer.t * 0.1)));
+		environment.background_color = vec3(157.0,221.0,237.0)/256.0 * (std::max(0.1, sin(sun_time * 0.1)));
 
 		// only draws if above water
-		if(sun.model.translation.y >= water.model.translation.y-2.0)
+		if(sun.model.translation.y >= water.model.translation.y-2.0){
 			draw(sun, environment);
+			++draw_calls;
+		}
 	}
 
 
 	// DRAW OCEAN (chunk model + fov culling + "simplistic" tesselation)
-	input.uniform_int["u_resolution"] = RESOLUTION;
+	render_timer.begin();
+	input.uniform_int["u_resolution"] = RESOLUTION; // displacement normalization of the full spectrum (lower resolutions are its central band)
 	input.uniform_vec3["u_bg_color"] = environment.background_color;
 	input.uniform_float["u_fog_dmax"] = gui.fog_dmax;
+	input.uniform_float["u_blend"] = temporal_lod.blend(simulation_time);
+	input.uniform_int["u_map_layer"] = 2 * map_set;
+	input.uniform_int["u_map_layer_prev"] = 2 * (1 - map_set);
 
 	vec3 player_u0v = vec3(std::floor(player_position.x/ocean_length), 0, std::floor(player_position.z/ocean_length));
 	float fov = camera_projection.field_of_view;	 
@@ -167,22 +309,72 @@ void scene_structure::display_frame()
 				if(dot(view_cone_dir, view_point_dir) > cosfov) goto draw;
 			}
 		}
+		++tiles_culled;
 		continue;
 		
 		draw:
-		auto &agua = std::max(neigh.x, neigh.y) >= 2 || std::min(neigh.x, neigh.z) <= -2 ?  water_lq : water; // tesselation
+		auto &agua = std::max(std::abs(neigh.x), std::abs(neigh.z)) >= lq_ring ?  water_lq : water; // tesselation (rings around the camera tile)
 		agua.model.translation = corner;
 		draw(agua, environment, 1, true, input);
 		if(gui.display_wireframe) draw_wireframe(agua, environment);
+		++tiles_drawn;
+		tiles_lq += &agua == &water_lq ? 1 : 0;
+		draw_calls += gui.display_wireframe ? 2 : 1;
 	}
 	input.clear();
+	uint64_t const render_section = render_timer.end();
 	
 	if (gui.display_frame){
+		debug_z.texture = displacement_view[map_set];
+		debug_x.texture = normal_view[map_set];
+		debug_y.texture = spectrum_t_image.id != 0 ? spectrum_t_image : displacement_view[map_set];
 		draw(global_frame, environment);
 		draw(debug_x, environment);
 		draw(debug_y, environment);
 		draw(debug_z, environment);
+		draw_calls += 4;
+	}
+
+	// QUALITY GOVERNOR
+	quality_timings timings;
+	timings.frame_ms = 1000.f * inputs.time_interval;
+	timings.cpu_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frame_start).count();
+	// no glFinish, even in the flight benchmark: the timer queries arrive later and are given back to their frame
+	std::vector<gpu_timer_section> completed[2];
+	float const simulation_gpu_ms = simulation_timer.consume(flight.enabled ? &completed[0] : nullptr);
+	timings.simulation_ms = use_cpu_engine ? (keyframe ? ocean_cpu.last_update_ms : 0.f) : simulation_gpu_ms;
+	timings.render_ms = render_timer.consume(flight.enabled ? &completed[1] : nullptr);
+	temporal_lod.end_frame(inputs.time_interval, std::max(timings.cpu_ms, timings.simulation_ms + timings.render_ms) / 1000.f);
+	if (timings_trace.is_open())
+		quality_trace_line(timings_trace, timings, current_quality());
+	if (flight.enabled) {
+		flight_frame_record record;
+		record.cpu_ms = timings.cpu_ms;
+		record.gpu_ms = timings.render_ms + (use_cpu_engine ? 0.f : timings.simulation_ms);
+		record.draw_calls = draw_calls;
+		record.tiles_drawn = tiles_drawn;
+		record.tiles_culled = tiles_culled;
+		record.tiles_lq = tiles_lq;
+		record.keyframe = keyframe;
+		record.gpu_sections[0] = keyframe && !use_cpu_engine ? simulation_section : 0;
+		record.gpu_sections[1] = render_section;
+		record.gpu_measured = render_section != 0 && (!keyframe || use_cpu_engine || simulation_section != 0);
+		flight.record(record);
+		if (flight.finished()) {
+			glFinish(); // after the last frame: the queries still in flight complete
+			simulation_timer.consume(&completed[0]);
+			render_timer.consume(&completed[1]);
+		}
+		for (int t = 0; t < 2; ++t)
+			for (gpu_timer_section const& section : completed[t])
+				flight.add_gpu_time(t, section);
 	}
+
+	governor.enabled = gui.quality_governor;
+	governor.target_ms = gui.frame_budget_ms;
+	governor.max_update_period = gui.temporal_lod ? 4 : 1;
+	if (governor.update(timings))
+		apply_quality(governor.settings);
 }
 
 void scene_structure::display_gui()
@@ -194,8 +386,30 @@ void scene_structure::display_gui()
 	bool wind_mag_changed = ImGui::SliderFloat("Wind Magnitude", &gui.wind_magnitude, 20.f, 60.f);
 	bool wind_ang_changed = ImGui::SliderFloat("Wind Angle", &gui.wind_angle, 0, 359);
 	ImGui::SliderFloat("Choppiness", &gui.choppiness, 0.f, 3.f);
+	ImGui::Checkbox("Foam", &gui.foam);
+	ImGui::SliderFloat("Foam threshold", &gui.foam_threshold, 0.f, 1.f);
+	ImGui::SliderFloat("Foam lifetime (s)", &gui.foam_lifetime, 0.f, 10.f);
+	ImGui::Checkbox("Temporal LOD", &gui.temporal_lod);
+	ImGui::SliderFloat("LOD error", &gui.lod_error, 0.001f, 0.1f, "%.3f");
+	ImGui::SliderFloat("Frame budget (ms)", &gui.frame_budget_ms, 4.f, 50.f);
+	ImGui::Text("Simulation period: %d frame(s) (band %d)", temporal_lod.period(temporal_lod.active_band, inputs.time_interval), temporal_lod.active_band);
+	if (ImGui::Checkbox("Quality governor", &gui.quality_governor) && gui.quality_governor)
+		governor.initialize(current_quality());
+	ImGui::Text("Quality: %dx%d, %dx%d tiles, low quality from ring %d", resolution, resolution, num_patches, num_patches, lq_ring);
+	if (ImGui::TreeNode("GPU memory")) {
+		size_t total = 0;
+		for (auto const& resource : gpu_memory_report()) {
+			ImGui::Text("%s: %.1f MB", resource.first.c_str(), resource.second / (1024.0 * 1024.0));
+			total += resource.second;
+		}
+		ImGui::Text("total: %.1f MB", total / (1024.0 * 1024.0));
+		ImGui::TreePop();
+	}
 	
-	compute_initial_spectrum |= wind_ang_changed | wind_mag_changed;
+	if (wind_ang_changed | wind_mag_changed) {
+		spectrum_seed = std::random_device()();
+		compute_initial_spectrum = true;
+	}
 }
 
 void scene_structure::mouse_move_event()
@@ -213,109 +427,433 @@ void scene_structure::keyboard_event()
 }
 void scene_structure::idle_frame()
 {
-	camera_control.idle_frame(environment.camera_view);
+	if (flight.enabled) {
+		// scripted camera, the inputs are ignored
+		vec3 eye, target;
+		flight.path.evaluate(flight.path_time(), eye, target);
+		camera_control.look_at(eye, target, {0,1,0});
+		environment.camera_view = camera_control.camera_model.matrix_view();
+	}
+	else
+		camera_control.idle_frame(environment.camera_view);
+
+	if (flight_recorder.is_open()) {
+		vec3 const eye = camera_control.camera_model.position();
+		flight_recorder.record(simulation_time, eye, eye + camera_control.camera_model.front());
+	}
 }
 
 // OCEAN COMPUTATION
+double scene_structure::simulate(double time){
+	// the last keyframe becomes the previous one: write the other layers of maps_image
+	map_set = 1 - map_set;
+
+	// its foam fades over the time between the keyframes (the CPU engine keeps its own)
+	float const lifetime = gui.foam_lifetime;
+	foam_decay = foam_time >= 0.0 && lifetime > 0.f ? float(std::exp(-std::max(time - foam_time, 0.0) / lifetime)) : 0.f;
+	foam_time = time;
+
+	if (use_cpu_engine)
+	{
+		// spectrum, six-step FFTs and maps computed on CPU
+		return cpu_update(time);
+	}
+
+	// generate time varying spectrum from initial spectrum
+	spectrum_update(time);
+
+	// central band for the distant tiles, copied before the FFTs transform the spectra in place
+	if (band_resolution > 0)
+		band_update();
+
+	// reorder spectrum texture (just for printing it in the screen, not necessary to generate the ocean)
+	if (gui.display_frame) {
+		if (spectrum_t_image.id == 0)
+			spectrum_t_image.initialize_texture_2d_on_gpu(resolution, resolution, GL_RGBA32F, GL_TEXTURE_2D, GL_REPEAT, GL_REPEAT, GL_NEAREST, GL_NEAREST);
+		texture_ordering(spectrum_fields, 0, spectrum_t_image);
+	}
+	else if (spectrum_t_image.id != 0)
+		spectrum_t_image.release();
+
+	// where the magic happpens :) (every field at once)
+	fft(fft_vertical, spectrum_fields, spectrum_fields_temp, resolution);
+	fft(fft_horizontal, spectrum_fields, spectrum_fields_temp, resolution);
+
+	// save normal and displacement maps to textures
+	normal_update(spectrum_fields, maps_image, resolution);
+
+	// same for the band (a few percent of the full FFT at a quarter of the resolution)
+	if (band_resolution > 0) {
+		fft(fft_vertical, band_fields, band_fields_temp, band_resolution);
+		fft(fft_horizontal, band_fields, band_fields_temp, band_resolution);
+		normal_update(band_fields, band_maps_image, band_resolution);
+	}
+	return time;
+}
+
+ocean_foam_parameters scene_structure::foam_parameters() const
+{
+	ocean_foam_parameters foam;
+	// the tiles apply displacement / RESOLUTION^2 on a patch of ocean_length for ocean_size in the spectrum
+	foam.jacobian_scale = gui.foam ? 1.f / (scale * RESOLUTION * RESOLUTION) : 0.f;
+	foam.threshold = gui.foam_threshold;
+	foam.lifetime = gui.foam_lifetime;
+	return foam;
+}
+
+bool scene_structure::foam_benchmark(int frames)
+{
+	// keyframes back to back at 60 Hz, the first one of each run warms up
+	//  without foam the Jacobian derivatives are not packed: the reference is the simulation without foam at all
+	double const dt = 1.0 / 60.0;
+	bool const foam = gui.foam;
+	if (compute_initial_spectrum) {
+		initial_spectrum();
+		compute_initial_spectrum = false;
+	}
+
+	// GPU path: timer queries around simulate(), serialized with glFinish
+	double gpu_ms[2] = {};
+	if (!use_cpu_engine) {
+		for (int on = 0; on < 2; ++on) {
+			gui.foam = on == 1;
+			for (int f = 0; f <= frames; ++f) {
+				simulation_timer.begin();
+				simulate(f * dt);
+				simulation_timer.end();
+				glFinish();
+				float const ms = simulation_timer.consume();
+				if (f > 0) gpu_ms[on] += ms / frames;
+			}
+		}
+	}
+
+	// CPU engine: latency of the task graph on the same ocean (resolution, band, wind) as the GPU path
+	double cpu_ms[2] = {};
+	ocean_cpu_parameters const parameters = cpu_parameters();
+	ocean_cpu_structure engine;
+	engine.initialize(parameters);
+	for (int on = 0; on < 2; ++on) {
+		gui.foam = on == 1;
+		engine.foam = foam_parameters();
+		for (int f = 0; f <= frames; ++f) {
+			engine.update(f * dt, gui.choppiness, (f + 1) * dt);
+			if (f > 0) cpu_ms[on] += engine.last_update_ms / frames;
+		}
+	}
+	gui.foam = foam;
+
+	bool within_budget = true;
+	auto report = [&within_budget](std::string const& name, double const* ms) {
+		double const increase = ms[0] > 0.0 ? 100.0 * (ms[1] - ms[0]) / ms[0] : 0.0;
+		within_budget = within_budget && increase <= 15.0;
+		std::cout << "[foam benchmark] " << name << ": " << ms[0] << " ms without foam, " << ms[1] << " ms with foam (" << (increase >= 0.0 ? "+" : "") << increase << "%)" << std::endl;
+	};
+	if (!use_cpu_engine)
+		report("GPU simulation " + std::to_string(resolution) + "x" + std::to_string(resolution) + (band_resolution > 0 ? " + band " + std::to_string(band_resolution) : ""), gpu_ms);
+	report("CPU engine " + std::to_string(parameters.resolution) + "x" + std::to_string(parameters.resolution) + (parameters.band_resolution > 0 ? " + band " + std::to_string(parameters.band_resolution) : ""), cpu_ms);
+	std::cout << "[foam benchmark] " << (within_budget ? "within" : "over") << " the 15% budget (" << frames << " keyframes per run)" << std::endl;
+	return within_budget;
+}
+
+std::vector<precision_variant> scene_structure::precision_variants()
+{
+	std::vector<precision_variant> variants;
+	if (use_cpu_engine) return variants;
+
+	// the case's h_0 replaces the output of spectrum_0, then a keyframe runs as usual and the maps are read back
+	auto run = [this](precision_case const& c, std::vector<complex_f> const& spectrum_0, precision_output& out, bool band) {
+		if (c.ocean_size != ocean_size || c.resolution > RESOLUTION) return false;
+		int const resolution_before = resolution;
+		float const choppiness_before = gui.choppiness;
+		allocate_simulation(c.resolution);
+
+		int const n = band ? band_resolution : resolution;
+		if (n > 0) {
+			glBindTexture(GL_TEXTURE_2D, spectrum_0_image.id);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, resolution, resolution, GL_RG, GL_FLOAT, spectrum_0.data());
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			gui.choppiness = c.choppiness;
+			simulation_timer.begin();
+			simulate(c.time);
+			simulation_timer.end();
+			glFinish();
+			out.ms = simulation_timer.consume();
+
+			size_t const layer = 4 * size_t(n) * n;
+			std::vector<float> layers(4 * layer);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, band ? band_maps_image.id : maps_image.id);
+			glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, GL_FLOAT, layers.data());
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+			out.resolution = n;
+			out.displacement.assign(layers.begin() + 2 * map_set * layer, layers.begin() + (2 * map_set + 1) * layer);
+			out.normal.assign(layers.begin() + (2 * map_set + 1) * layer, layers.begin() + (2 * map_set + 2) * layer);
+		}
+
+		gui.choppiness = choppiness_before;
+		allocate_simulation(resolution_before);
+		compute_initial_spectrum = true;
+		return n > 0;
+	};
+
+	// fp32 on the GPU, but sin/cos of the twiddles and phases are less accurate on hardware than on a software driver
+	//  phase(k) + omega(k) t is a float sum: late in an epoch it alone costs up to ~5e-6 RMS (float CPU engine, any N)
+	precision_variant gpu;
+	gpu.name = "gpu compute shaders";
+	gpu.max_resolution = RESOLUTION;
+	gpu.budget_max = 5e-5;
+	gpu.budget_rms = 1e-5;
+	gpu.run = [run](precision_case const& c, std::vector<complex_f> const& spectrum_0, precision_output& out) { return run(c, spectrum_0, out, false); };
+	variants.push_back(gpu);
+
+	precision_variant band = gpu;
+	band.name = "gpu band";
+	band.run = [run](precision_case const& c, std::vector<complex_f> const& spectrum_0, precision_output& out) { return run(c, spectrum_0, out, true); };
+	variants.push_back(band);
+	return variants;
+}
+
+ocean_cpu_parameters scene_structure::cpu_parameters() const
+{
+	float const wind_angle_rad = PI*gui.wind_angle/180.f;
+	ocean_cpu_parameters parameters;
+	parameters.resolution = resolution;
+	parameters.ocean_size = ocean_size;
+	parameters.amplitude = amplitude;
+	parameters.wind_x = gui.wind_magnitude * cos(wind_angle_rad);
+	parameters.wind_z = gui.wind_magnitude * sin(wind_angle_rad);
+	parameters.seed = spectrum_seed;
+	parameters.band_resolution = band_resolution;
+	return parameters;
+}
+
 void scene_structure::initial_spectrum(){
 
+	float wind_angle_rad = PI*gui.wind_angle/180.f;
+
+	if (use_cpu_engine) {
+		ocean_cpu.initialize(cpu_parameters());
+		return;
+	}
+
 	glUseProgram(spectrum_0.id);
-	input.uniform_int["u_resolution"] = RESOLUTION;
+	input.uniform_int["u_resolution"] = resolution;
 	input.uniform_int["u_ocean_size"] = ocean_size; 
 	input.uniform_float["u_amplitude"] = amplitude;
 
-	float wind_angle_rad = PI*gui.wind_angle/180.f;
 	input.uniform_vec2["u_wind"] = vec2(gui.wind_magnitude * cos(wind_angle_rad), gui.wind_magnitude * sin(wind_angle_rad));
 	
 	input.send_opengl_uniform(spectrum_0);
 	input.clear();
 	
-	// random dist generation
-	std::vector<float> gaussian_rnd(4* RESOLUTION * RESOLUTION);
-	std::random_device dev;
-	std::mt19937 rng(dev());
+	// random dist generation, always at full resolution: a lower resolution takes the texels of its wave vectors (central band)
+	std::vector<float> gaussian_full(4* RESOLUTION * RESOLUTION);
+	std::mt19937 rng(spectrum_seed);
 	std::normal_distribution<float> dist(0.f, 1.f); //~N(0,1)
-	for (int i = 0; i < (int) gaussian_rnd.size(); ++i)
-		gaussian_rnd[i] = dist(rng);
-	gaussian_noise.initialize_texture_2d_on_gpu(RESOLUTION, RESOLUTION, GL_RGBA32F, GL_TEXTURE_2D, GL_CLAMP_TO_BORDER, GL_CLAMP_TO_BORDER, GL_NEAREST, GL_NEAREST, gaussian_rnd.data());
+	for (int i = 0; i < (int) gaussian_full.size(); ++i)
+		gaussian_full[i] = dist(rng);
+	std::vector<float> gaussian_rnd(4* resolution * resolution);
+	int const half = resolution >> 1;
+	for (int y = 0; y < resolution; ++y) {
+		for (int x = 0; x < resolution; ++x) {
+			int const fx = ((x + half) % resolution - half + RESOLUTION) % RESOLUTION;
+			int const fy = ((y + half) % resolution - half + RESOLUTION) % RESOLUTION;
+			std::copy_n(&gaussian_full[4 * (size_t(fy) * RESOLUTION + fx)], 4, &gaussian_rnd[4 * (size_t(y) * resolution + x)]);
+		}
+	}
+	gaussian_noise.initialize_texture_2d_on_gpu(resolution, resolution, GL_RGBA32F, GL_TEXTURE_2D, GL_CLAMP_TO_BORDER, GL_CLAMP_TO_BORDER, GL_NEAREST, GL_NEAREST, gaussian_rnd.data());
 	
-	glBindImageTexture(0, spectrum_0_image.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+	glBindImageTexture(0, spectrum_0_image.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
 	glBindImageTexture(1, gaussian_noise.id, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
 
-	glDispatchCompute(RESOLUTION / WORK_GROUP_DIM, RESOLUTION / WORK_GROUP_DIM, 1);
+	glDispatchCompute(resolution / WORK_GROUP_DIM, resolution / WORK_GROUP_DIM, 1);
 	glFinish();
+	gaussian_noise.release();
 }
 
-void scene_structure::spectrum_update(){
+void scene_structure::spectrum_update(double time){
+	// new epoch: upload the wrapped phases
+	if (dispersion.update(time)) {
+		glBindTexture(GL_TEXTURE_2D, dispersion_image.id);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, resolution, resolution, GL_RG, GL_FLOAT, dispersion.texels.data());
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
 	glUseProgram(spectrum_t.id);
-	input.uniform_int["u_resolution"] = RESOLUTION;
+	input.uniform_int["u_resolution"] = resolution;
 	input.uniform_int["u_ocean_size"] = ocean_size; 
 	input.uniform_float["u_choppiness"] = gui.choppiness;
-	timer.update();
-	input.uniform_float["u_time"] = timer.t;
+	input.uniform_float["u_time"] = dispersion.local_time(time);
+	input.uniform_int["u_foam"] = foam_parameters().enabled() ? 1 : 0; // Jacobian derivatives packed only for the foam
 	input.send_opengl_uniform(spectrum_t);
 	input.clear();
 
-	glBindImageTexture(0, spectrum_0_image.id, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-	glBindImageTexture(1, dy_image.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
-	glBindImageTexture(2, dx_image.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
-	glBindImageTexture(3, dz_image.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+	glBindImageTexture(0, spectrum_0_image.id, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG32F);
+	glBindImageTexture(1, spectrum_fields.id, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RG32F);
+	glBindImageTexture(2, dispersion_image.id, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG32F);
 
-	glDispatchCompute(RESOLUTION / WORK_GROUP_DIM, RESOLUTION / WORK_GROUP_DIM, 1);
+	glDispatchCompute(resolution / WORK_GROUP_DIM, resolution / WORK_GROUP_DIM, 1);
 	glFinish();
 }
 
-void scene_structure::normal_update(){
+void scene_structure::band_update(){
+	glUseProgram(spectrum_band.id);
+	input.uniform_int["u_resolution"] = resolution;
+	input.uniform_int["u_band_resolution"] = band_resolution;
+	input.send_opengl_uniform(spectrum_band);
+	input.clear();
+
+	glBindImageTexture(0, spectrum_fields.id, 0, GL_TRUE, 0, GL_READ_ONLY, GL_RG32F);
+	glBindImageTexture(1, band_fields.id, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RG32F);
+
+	glDispatchCompute(band_resolution / WORK_GROUP_DIM, band_resolution / WORK_GROUP_DIM, NUM_SPECTRUM_FIELDS);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+}
+
+void scene_structure::normal_update(opengl_texture_image_structure_custom &fields, opengl_texture_image_structure_custom &maps, int n){
+	ocean_foam_parameters const foam = foam_parameters();
 	glUseProgram(normal.id);
+	input.uniform_int["u_map_layer"] = 2 * map_set;
+	input.uniform_int["u_map_layer_prev"] = 2 * (1 - map_set);
+	input.uniform_float["u_jacobian_scale"] = foam.jacobian_scale;
+	input.uniform_float["u_foam_threshold"] = foam.threshold;
+	input.uniform_float["u_foam_gain"] = foam.gain;
+	input.uniform_float["u_foam_decay"] = foam_decay;
+	input.send_opengl_uniform(normal);
+	input.clear();
 
-	glBindImageTexture(0, dy_image.id, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-	glBindImageTexture(1, dx_image.id, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-	glBindImageTexture(2, dz_image.id, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-	glBindImageTexture(3, normal_image.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
-	glBindImageTexture(4, displacement_image.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+	// the previous keyframe's foam is read from the other layers
+	glBindImageTexture(0, fields.id, 0, GL_TRUE, 0, GL_READ_ONLY, GL_RG32F);
+	glBindImageTexture(1, maps.id, 0, GL_TRUE, 0, GL_READ_WRITE, GL_RGBA32F);
 
-	glDispatchCompute(RESOLUTION / WORK_GROUP_DIM, RESOLUTION / WORK_GROUP_DIM, 1);
+	glDispatchCompute(n / WORK_GROUP_DIM, n / WORK_GROUP_DIM, 1);
 	glFinish();
 }
 
-void scene_structure::fft(opengl_shader_structure_custom &shader, opengl_texture_image_structure_custom &texture){
+void scene_structure::fft(opengl_shader_structure_custom &shader, opengl_texture_image_structure_custom &fields, opengl_texture_image_structure_custom &fields_temp, int n){
 	glUseProgram(shader.id);
-	input.uniform_int["u_resolution"] = RESOLUTION; 
+	input.uniform_int["u_resolution"] = n; 
 	input.send_opengl_uniform(shader); 
-	
-	auto& tmp = temp_image;
 
-	bool swap_temp = false;
-	for (int stride = 1, count = RESOLUTION; count >= 1; stride <<= 1, count >>= 1)
+	// log2(n) passes (a count of 1 would only copy), the result ends in fields whatever the parity
+	for (int stride = 1, count = n; count >= 2; stride <<= 1, count >>= 1)
 	{
-		glBindImageTexture(0, texture.id, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-		glBindImageTexture(1, tmp.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+		glBindImageTexture(0, fields.id, 0, GL_TRUE, 0, GL_READ_ONLY, GL_RG32F);
+		glBindImageTexture(1, fields_temp.id, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RG32F);
 
 		input.uniform_int["u_stride"] = stride;
 	 	input.uniform_int["u_count"] = count;
 		input.send_opengl_uniform(shader);
 
-		// two calculations per shader execution
-		glDispatchCompute(RESOLUTION, RESOLUTION / 2, 1);
+		// two calculations per shader execution, one layer per field
+		glDispatchCompute(n, n / 2, NUM_SPECTRUM_FIELDS);
 		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 	
-		std::swap(tmp, texture);
-		swap_temp = !swap_temp;
+		std::swap(fields, fields_temp);
 	}
-	if(swap_temp) std::swap(tmp, texture);
 	input.clear();
 }
 
+double scene_structure::cpu_update(double time){
+	// the spectrum of the expected next keyframe is computed during this frame's FFTs
+	float const dt = inputs.time_interval;
+	ocean_cpu.prediction_tolerance = 0.5f * dt;
+	ocean_cpu.foam = foam_parameters();
+	double const maps_time = ocean_cpu.update(time, gui.choppiness, time + temporal_lod.period(temporal_lod.active_band, dt) * dt);
+
+	// upload the maps (same layout as normal.comp.glsl output)
+	glBindTexture(GL_TEXTURE_2D_ARRAY, maps_image.id);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 2 * map_set, resolution, resolution, 1, GL_RGBA, GL_FLOAT, ocean_cpu.displacement.data());
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 2 * map_set + 1, resolution, resolution, 1, GL_RGBA, GL_FLOAT, ocean_cpu.normal.data());
+	if (band_resolution > 0) {
+		glBindTexture(GL_TEXTURE_2D_ARRAY, band_maps_image.id);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 2 * map_set, band_resolution, band_resolution, 1, GL_RGBA, GL_FLOAT, ocean_cpu.band_displacement.data());
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 2 * map_set + 1, band_resolution, band_resolution, 1, GL_RGBA, GL_FLOAT, ocean_cpu.band_normal.data());
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return maps_time;
+}
+
+// SHARED MEMORY PUBLICATION
+void scene_structure::publish_heightfield(double time){
+	if (!heightfield_publisher.is_open()) return;
+
+	// CPU engine: the map is already in host memory
+	if (use_cpu_engine) {
+		heightfield_publisher.publish(ocean_cpu.displacement.data(), time);
+		return;
+	}
+
+	// GPU: displacement and normal layers of this keyframe go to the readback ring (dropped if every slot is busy)
+	if (readback.is_initialized())
+		readback.request(maps_image.id, resolution, resolution, { 2 * map_set, 2 * map_set + 1 }, readback_roi, keyframe_count, time);
+}
+
+void scene_structure::poll_heightfield_readback(){
+	if (!heightfield_publisher.is_open()) return;
+
+	// newest completed keyframe, read in place from the mapped PBO
+	readback_frame frame;
+	if (!readback.acquire_latest(frame, published_keyframe)) return;
+	heightfield_publisher.publish(frame.layer(0), frame.time);
+	published_keyframe = frame.frame;
+	readback.release(frame);
+}
+
 // UTILITY
-void scene_structure::texture_ordering(opengl_texture_image_structure_custom &input_image, opengl_texture_image_structure_custom &output_image){
+void scene_structure::texture_ordering(opengl_texture_image_structure_custom &input_array, int layer, opengl_texture_image_structure_custom &output_image){
 	glUseProgram(orientation.id);
-	input.uniform_int["u_resolution"] = RESOLUTION;
+	input.uniform_int["u_resolution"] = resolution;
+	input.uniform_int["u_layer"] = layer;
 	input.send_opengl_uniform(orientation);
 	input.clear();
 
-	glBindImageTexture(0, input_image.id, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+	glBindImageTexture(0, input_array.id, 0, GL_TRUE, 0, GL_READ_ONLY, GL_RG32F);
 	glBindImageTexture(1, output_image.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
-	glDispatchCompute(RESOLUTION / WORK_GROUP_DIM, RESOLUTION / WORK_GROUP_DIM, 1);
+	glDispatchCompute(resolution / WORK_GROUP_DIM, resolution / WORK_GROUP_DIM, 1);
 	glFinish();
-}
\ No newline at end of file
+}
+
+std::vector<std::pair<std::string, size_t>> scene_structure::gpu_memory_report() const{
+	std::vector<std::pair<std::string, size_t>> report;
+	auto add = [&report](std::string const& name, size_t bytes) { if (bytes > 0) report.push_back({ name, bytes }); };
+	add("initial spectrum", spectrum_0_image.bytes());
+	add("dispersion", dispersion_image.bytes());
+	add("spectrum fields", spectrum_fields.bytes());
+	add("FFT ping-pong", spectrum_fields_temp.bytes());
+	add("displacement/normal maps", maps_image.bytes());
+	add("band fields", band_fields.bytes() + band_fields_temp.bytes());
+	add("band maps", band_maps_image.bytes());
+	add("gaussian noise", gaussian_noise.bytes());
+	add("debug spectrum", spectrum_t_image.bytes());
+	add("readback ring", readback.bytes());
+	return report;
+}
+
+void scene_structure::print_gpu_memory_report() const{
+	size_t total = 0;
+	std::cout << "GPU memory (" << resolution << "x" << resolution << "):" << std::endl;
+	for (auto const& resource : gpu_memory_report()) {
+		std::cout << "  " << resource.first << ": " << resource.second / (1024.0 * 1024.0) << " MB" << std::endl;
+		total += resource.second;
+	}
+	std::cout << "  total: " << total / (1024.0 * 1024.0) << " MB" << std::endl;
+}
+
+std::string scene_structure::benchmark_configuration() const{
+	std::ostringstream out;
+	char const* renderer = reinterpret_cast<char const*>(glGetString(GL_RENDERER));
+	out << "{ \"renderer\": " << json_string(renderer ? renderer : "") << ", \"window\": [" << window.width << ", " << window.height << "]"
+		<< ", \"engine\": \"" << (use_cpu_engine ? "cpu" : "gpu") << "\", \"resolution\": " << resolution
+		<< ", \"patches\": " << num_patches << ", \"lq_ring\": " << lq_ring
+		<< ", \"temporal_lod\": " << (gui.temporal_lod ? "true" : "false");
+	// keyframe periods of the bands (frames), fixed during the flight
+	float const dt = flight.enabled ? flight.time_step : inputs.time_interval;
+	out << ", \"lod_pressure\": " << temporal_lod.pressure << ", \"lod_error\": " << temporal_lod.error_tolerance << ", \"band_periods\": [";
+	for (int b = 0; b < int(temporal_lod.bands.size()); ++b)
+		out << (b ? ", " : "") << "{ \"distance\": " << temporal_lod.bands[b].distance << ", \"period\": " << temporal_lod.period(b, dt) << " }";
+	out << "] }";
+	return out.str();
+}
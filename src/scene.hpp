@@ -4,6 +4,16 @@
 #include "cgp/cgp.hpp"
 #include "cgp_custom.hpp"
 #include "environment.hpp"
+#include "dispersion.hpp"
+#include "ocean_cpu.hpp"
+#include "temporal_lod.hpp"
+#include "shm_heightfield.hpp"
+#include "readback_ring.hpp"
+#include "quality_governor.hpp"
+#include "flight_benchmark.hpp"
+#include "precision_harness.hpp"
+
+#include <fstream>
 
 using cgp::mesh_drawable;
 
@@ -15,6 +25,13 @@ struct gui_parameters {
 	float wind_magnitude = 40.f;
 	float wind_angle = 45.f;
 	float choppiness = 1.5f;
+	bool foam = true;
+	float foam_threshold = 0.6f; // Jacobian below which the surface foams
+	float foam_lifetime = 2.f;   // s
+	bool temporal_lod = true;
+	float lod_error = 0.02f;
+	float frame_budget_ms = 16.7f;
+	bool quality_governor = true;
 };
 
 // The structure of the custom scene
@@ -39,26 +56,73 @@ struct scene_structure : cgp::scene_inputs_generic {
 
 	// scene_elements_structure scene_elements;
 	timer_basic timer;
+	double simulation_time = 0.0; // the float timer.t loses precision after days of uptime
 	mesh_drawable terrain;
 	mesh_drawable water, water_lq;
 	mesh_drawable sun;
 
 	std::vector<vec3> neighbors;
 
+	// runtime quality, moved by the governor: simulation resolution (<= RESOLUTION), tiles per side, tiles at a ring distance >= lq_ring use water_lq
+	int resolution = 0;
+	int num_patches = 0;
+	int lq_ring = 0;
+	unsigned int spectrum_seed = 0; // smaller resolutions use the central band of the same noise: the long waves do not change
+	quality_governor_structure governor;
+	opengl_gpu_timer simulation_timer, render_timer;
+	std::ofstream timings_trace; // --record-timings
+
+	// scripted camera flight (--benchmark-flight) and recording of the camera (--record-flight)
+	flight_benchmark_structure flight;
+	camera_path_recorder flight_recorder;
+	// counters of the last frame
+	int draw_calls = 0, tiles_drawn = 0, tiles_culled = 0, tiles_lq = 0;
+
 	// compute shaders 
-	opengl_shader_structure_custom spectrum_0, spectrum_t, fft_horizontal, fft_vertical, normal, orientation;
+	opengl_shader_structure_custom spectrum_0, spectrum_t, spectrum_band, fft_horizontal, fft_vertical, normal, orientation;
 	
 	// vert / frag shaders
-	opengl_shader_structure ocean;
+	opengl_shader_structure_custom ocean;
  
 	// textures
-	opengl_texture_image_structure_custom spectrum_0_image, spectrum_t_image, temp_image, normal_image, displacement_image, dx_image, dz_image, dy_image, debug_image;
-	opengl_texture_image_structure_custom gaussian_noise;
+	opengl_texture_image_structure_custom spectrum_0_image;                        // h_0(k) (RG)
+	opengl_texture_image_structure_custom dispersion_image;                        // (omega(k), phase at the epoch) (RG), see dispersion.hpp
+	opengl_texture_image_structure_custom spectrum_fields, spectrum_fields_temp;   // h, Dx, nx, Dz, nz (one RG layer each) and their FFT ping-pong
+	opengl_texture_image_structure_custom maps_image;                              // (displacement, normal) of the last two keyframes (4 RGBA layers)
+	opengl_texture_image_structure_custom displacement_view[2], normal_view[2];    // layers of maps_image as 2D textures (debug quads, readback)
+	opengl_texture_image_structure_custom spectrum_t_image;                        // reordered h(k,t), only allocated while the debug frame is shown
+	opengl_texture_image_structure_custom gaussian_noise;                          // only alive while h_0 is computed
+	int map_set = 0; // layers 2*map_set (displacement) and 2*map_set+1 (normal) hold the last keyframe
+	// distant tiles: central band of the spectrum transformed at band_resolution (band-limited, no aliasing), same layers as maps_image
+	opengl_texture_image_structure_custom band_fields, band_fields_temp, band_maps_image;
+	int band_resolution = 0; // 0: the distant tiles sample maps_image
+	// foam accumulated in the w channel of the displacement layers, fading since the previous keyframe
+	double foam_time = -1.0; // -1: the previous layers hold no foam (start, new allocation)
+	float foam_decay = 0.f;
 
 	// utility uniform
 	uniform_generic_structure_custom input;
 
 	bool compute_initial_spectrum = true;
+
+	// wrapped phases omega(k) t of the GPU path (the CPU engine has its own)
+	dispersion_structure dispersion;
+
+	// CPU computation (six-step FFT) for resolutions >= CPU_ENGINE_THRESHOLD
+	ocean_cpu_structure ocean_cpu;
+	bool use_cpu_engine = false;
+
+	// keyframe scheduler (simulation rate vs interpolation error)
+	temporal_lod_structure temporal_lod;
+
+	// displacement/normal maps of the GPU path copied back to host memory without stalls (frame N-k)
+	readback_ring_structure readback;
+	readback_region readback_roi; // whole map, downsampled by --readback-step
+	long long keyframe_count = 0;
+	long long published_keyframe = -1;
+
+	// displacement map published to other processes (--publish-shm)
+	shm_heightfield_publisher heightfield_publisher;
 	
 	// debug meshs
 	mesh_drawable debug_x, debug_y, debug_z; 
@@ -67,11 +131,34 @@ struct scene_structure : cgp::scene_inputs_generic {
 	// Functions
 	// ****************************** //
 
+	void allocate_simulation(int resolution_arg);
+	void initialize_temporal_lod();
+	void initialize_neighbors();
+	void apply_quality(quality_settings const& settings);
+	quality_settings current_quality() const;
+
 	void initial_spectrum();
-	void fft(opengl_shader_structure_custom &shader, opengl_texture_image_structure_custom &texture);
-	void spectrum_update();
-	void normal_update();
-	void texture_ordering(opengl_texture_image_structure_custom &input_image, opengl_texture_image_structure_custom &output_image);
+	void fft(opengl_shader_structure_custom &shader, opengl_texture_image_structure_custom &fields, opengl_texture_image_structure_custom &fields_temp, int n);
+	void spectrum_update(double time);
+	void band_update();
+	void normal_update(opengl_texture_image_structure_custom &fields, opengl_texture_image_structure_custom &maps, int n);
+	double cpu_update(double time); // returns the time of the maps: a spectrum computed ahead is accepted within prediction_tolerance
+	double simulate(double time);
+	ocean_foam_parameters foam_parameters() const;
+	ocean_cpu_parameters cpu_parameters() const; // current resolution, band, wind and seed
+	// Simulation time without and with foam (GPU and CPU engine, current configuration); false if foam costs more than 15%
+	bool foam_benchmark(int frames);
+	// GPU path as variants of the precision harness (full maps and band), up to RESOLUTION
+	std::vector<precision_variant> precision_variants();
+	void publish_heightfield(double time);
+	void poll_heightfield_readback();
+	void texture_ordering(opengl_texture_image_structure_custom &input_array, int layer, opengl_texture_image_structure_custom &output_image);
+
+	// GPU memory allocated per resource (name, bytes)
+	std::vector<std::pair<std::string, size_t>> gpu_memory_report() const;
+	void print_gpu_memory_report() const;
+	// settings of the flight benchmark report (JSON object)
+	std::string benchmark_configuration() const;
 
 
 	void initialize();    // Standard initialization to be called before the animation loop
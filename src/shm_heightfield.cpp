@@ -0,0 +1,186 @@
+#include "shm_heightfield.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+static size_t align_64(size_t n) { return (n + 63) & ~size_t(63); }
+
+static shm_heightfield_slot& slot_of(shm_heightfield_header* header, uint64_t generation) {
+	return header->slots[generation % header->num_slots];
+}
+
+
+// PUBLISHER
+bool shm_heightfield_publisher::open(std::string const& name_arg, int width, int height, float displacement_scale, int num_slots)
+{
+#ifdef _WIN32
+	(void)name_arg; (void)width; (void)height; (void)displacement_scale; (void)num_slots;
+	std::cout << "[shm] POSIX shared memory is not available on this platform" << std::endl;
+	return false;
+#else
+	close();
+	num_slots = std::max(num_slots, 2);
+
+	size_t const header_bytes = align_64(offsetof(shm_heightfield_header, slots) + num_slots * sizeof(shm_heightfield_slot));
+	size_t const frame_bytes = align_64(size_t(width) * height * SHM_HEIGHTFIELD_CHANNELS * sizeof(float));
+	size_t const size = header_bytes + num_slots * frame_bytes;
+
+	int const fd = shm_open(name_arg.c_str(), O_CREAT | O_RDWR, 0666);
+	if (fd < 0) {
+		std::cout << "[shm] Cannot create shared memory " << name_arg << std::endl;
+		return false;
+	}
+	if (ftruncate(fd, off_t(size)) != 0) {
+		::close(fd);
+		return false;
+	}
+	void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (ptr == MAP_FAILED) return false;
+
+	name = name_arg;
+	mapping_size = size;
+	header = static_cast<shm_heightfield_header*>(ptr);
+	generation = 0;
+
+	// readers check the magic last: invalidate it while the layout changes
+	header->magic = 0;
+	std::atomic_thread_fence(std::memory_order_release);
+	header->version = SHM_HEIGHTFIELD_VERSION;
+	header->width = uint32_t(width);
+	header->height = uint32_t(height);
+	header->channels = SHM_HEIGHTFIELD_CHANNELS;
+	header->num_slots = uint32_t(num_slots);
+	header->frame_bytes = frame_bytes;
+	header->data_offset = header_bytes;
+	header->displacement_scale = displacement_scale;
+	header->latest.store(0, std::memory_order_relaxed);
+	for (int k = 0; k < num_slots; ++k) {
+		header->slots[k].sequence.store(0, std::memory_order_relaxed);
+		header->slots[k].generation = 0;
+		header->slots[k].time = 0.0;
+	}
+	std::atomic_thread_fence(std::memory_order_release);
+	header->magic = SHM_HEIGHTFIELD_MAGIC;
+	return true;
+#endif
+}
+
+void shm_heightfield_publisher::close()
+{
+#ifndef _WIN32
+	if (header == nullptr) return;
+	munmap(header, mapping_size);
+	shm_unlink(name.c_str());
+	header = nullptr;
+	mapping_size = 0;
+#endif
+}
+
+float* shm_heightfield_publisher::begin_write()
+{
+	shm_heightfield_slot& slot = slot_of(header, generation + 1);
+	uint64_t const sequence = slot.sequence.load(std::memory_order_relaxed);
+	slot.sequence.store(sequence + 1, std::memory_order_relaxed); // odd: being written
+	std::atomic_thread_fence(std::memory_order_release);
+	return const_cast<float*>(shm_heightfield_slot_data(header, int((generation + 1) % header->num_slots)));
+}
+
+void shm_heightfield_publisher::end_write(double time)
+{
+	++generation;
+	shm_heightfield_slot& slot = slot_of(header, generation);
+	slot.generation = generation;
+	slot.time = time;
+	slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release); // even: stable
+	header->latest.store(generation, std::memory_order_release);
+}
+
+void shm_heightfield_publisher::publish(float const* data, double time)
+{
+	std::memcpy(begin_write(), data, size_t(header->width) * header->height * SHM_HEIGHTFIELD_CHANNELS * sizeof(float));
+	end_write(time);
+}
+
+
+// SELF TEST
+int shm_heightfield_selftest(int resolution, double duration)
+{
+#ifdef _WIN32
+	(void)resolution; (void)duration;
+	std::cout << "[shm] self test needs POSIX shared memory" << std::endl;
+	return -1;
+#else
+	std::string const name = "/ocean_fft_selftest_" + std::to_string(getpid());
+	shm_heightfield_publisher publisher;
+	if (!publisher.open(name, resolution, resolution, 1.f, 3)) return -1;
+	size_t const count = size_t(resolution) * resolution * SHM_HEIGHTFIELD_CHANNELS;
+
+	// every value of a frame is its generation: a torn frame mixes two of them
+	auto frame_consistent = [count](float const* data, uint64_t generation) {
+		float const expected = float(generation % 1000000);
+		for (size_t i = 0; i < count; ++i)
+			if (data[i] != expected) return false;
+		return true;
+	};
+
+	pid_t const pid = fork();
+	if (pid == 0) {
+		// reader process
+		shm_heightfield_reader reader;
+		if (!reader.open(name)) _exit(255);
+		long checked = 0, rejected = 0, torn = 0;
+		std::vector<float> copy(count);
+		auto const start = std::chrono::steady_clock::now();
+		while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < duration) {
+			shm_heightfield_frame frame;
+			if (!reader.acquire_latest(frame)) continue;
+
+			// zero-copy read, alternating with copy_latest
+			bool consistent;
+			if (checked % 2 == 0) {
+				consistent = frame_consistent(frame.data, frame.generation);
+				if (!reader.still_valid(frame)) { ++rejected; continue; }
+			}
+			else {
+				if (!reader.copy_latest(copy.data(), frame)) { ++rejected; continue; }
+				consistent = frame_consistent(copy.data(), frame.generation);
+			}
+			++checked;
+			if (!consistent) ++torn;
+		}
+		std::cout << "[shm] reader: " << checked << " frames checked, " << rejected << " overwritten reads rejected, " << torn << " torn frames accepted" << std::endl;
+		reader.close();
+		_exit(int(std::min(torn, 254L)));
+	}
+
+	// publisher process
+	long published = 0;
+	auto const start = std::chrono::steady_clock::now();
+	while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < duration) {
+		float* data = publisher.begin_write();
+		std::fill(data, data + count, float((publisher.generation + 1) % 1000000));
+		publisher.end_write(double(published));
+		++published;
+	}
+	int status = 0;
+	waitpid(pid, &status, 0);
+	publisher.close();
+
+	int const torn = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	std::cout << "[shm] publisher: " << published << " frames published, " << (torn == 0 ? "no torn frame" : "TORN FRAMES DETECTED") << std::endl;
+	return torn;
+#endif
+}
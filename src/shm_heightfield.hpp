@@ -0,0 +1,30 @@
+#pragma once
+
+#include "shm_heightfield_reader.hpp"
+
+#include <string>
+
+// Writer side of the shared displacement map (layout and reader: shm_heightfield_reader.hpp)
+
+struct shm_heightfield_publisher {
+	std::string name;
+	shm_heightfield_header* header = nullptr;
+	size_t mapping_size = 0;
+	uint64_t generation = 0;
+
+	// name: POSIX shared memory object ("/ocean_fft"), created or resized
+	bool open(std::string const& name_arg, int width, int height, float displacement_scale, int num_slots = 3);
+	void close(); // unmaps and unlinks
+
+	bool is_open() const { return header != nullptr; }
+
+	// Zero-copy write: fill the returned pointer (width*height*4 floats) then call end_write
+	float* begin_write();
+	void end_write(double time);
+
+	// Copy a complete frame
+	void publish(float const* data, double time);
+};
+
+// Publisher and a forked reader process checking every frame for tearing; returns the number of torn frames accepted
+int shm_heightfield_selftest(int resolution, double duration);
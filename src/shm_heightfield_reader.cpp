@@ -0,0 +1,93 @@
+#include "shm_heightfield_reader.hpp"
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static shm_heightfield_slot const& slot_of(shm_heightfield_header const* header, uint64_t generation) {
+	return header->slots[generation % header->num_slots];
+}
+
+
+// READER
+bool shm_heightfield_reader::open(std::string const& name)
+{
+#ifdef _WIN32
+	(void)name;
+	return false;
+#else
+	close();
+	int const fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0) return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(shm_heightfield_header)) {
+		::close(fd);
+		return false;
+	}
+	void* ptr = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (ptr == MAP_FAILED) return false;
+
+	header = static_cast<shm_heightfield_header const*>(ptr);
+	mapping_size = size_t(info.st_size);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (header->magic != SHM_HEIGHTFIELD_MAGIC || header->version != SHM_HEIGHTFIELD_VERSION
+		|| header->data_offset + header->num_slots * header->frame_bytes > mapping_size) {
+		close();
+		return false;
+	}
+	return true;
+#endif
+}
+
+void shm_heightfield_reader::close()
+{
+#ifndef _WIN32
+	if (header == nullptr) return;
+	munmap(const_cast<shm_heightfield_header*>(header), mapping_size);
+	header = nullptr;
+	mapping_size = 0;
+#endif
+}
+
+bool shm_heightfield_reader::acquire_latest(shm_heightfield_frame& frame) const
+{
+	for (int attempt = 0; attempt < 64; ++attempt) {
+		uint64_t const latest = header->latest.load(std::memory_order_acquire);
+		if (latest == 0) return false;
+
+		shm_heightfield_slot const& slot = slot_of(header, latest);
+		uint64_t const sequence = slot.sequence.load(std::memory_order_acquire);
+		if (sequence & 1) continue; // lapped by the writer: latest moved on
+
+		frame.slot = int(latest % header->num_slots);
+		frame.sequence = sequence;
+		frame.generation = slot.generation;
+		frame.time = slot.time;
+		frame.data = shm_heightfield_slot_data(header, frame.slot);
+		if (still_valid(frame)) return true;
+	}
+	return false;
+}
+
+bool shm_heightfield_reader::still_valid(shm_heightfield_frame const& frame) const
+{
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return header->slots[frame.slot].sequence.load(std::memory_order_relaxed) == frame.sequence;
+}
+
+bool shm_heightfield_reader::copy_latest(float* dst, shm_heightfield_frame& frame, int max_attempts) const
+{
+	size_t const bytes = size_t(header->width) * header->height * header->channels * sizeof(float);
+	for (int attempt = 0; attempt < max_attempts; ++attempt) {
+		if (!acquire_latest(frame)) return false;
+		std::memcpy(dst, frame.data, bytes);
+		if (still_valid(frame)) return true;
+	}
+	return false;
+}
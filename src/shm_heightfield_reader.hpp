@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Publication of the displacement map to other processes through POSIX shared memory
+//  - ring of num_slots frames, each protected by a seqlock (odd sequence = being written)
+//  - the writer never waits for readers; a reader detects an overwritten slot by re-reading its sequence
+//  - zero-copy: readers access the frame in place and validate it afterwards (valid for num_slots-1 new frames)
+//  Frame: width x height RGBA float, unnormalized as the displacement map (multiply by displacement_scale)
+//  Reader side only (shared layout and reader): no OpenGL / CGP dependency, built as the shm_heightfield_reader library (library/)
+
+#define SHM_HEIGHTFIELD_MAGIC 0x4f434e53u // "OCNS"
+#define SHM_HEIGHTFIELD_VERSION 1u
+#define SHM_HEIGHTFIELD_CHANNELS 4
+
+// The seqlock is shared between processes: the atomics must be lock-free (a lock would live in each process, not in the mapping)
+#if __cplusplus >= 201703L
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shm_heightfield: std::atomic<uint64_t> must be lock-free");
+#else
+static_assert((sizeof(long) == sizeof(uint64_t) ? ATOMIC_LONG_LOCK_FREE : ATOMIC_LLONG_LOCK_FREE) == 2, "shm_heightfield: std::atomic<uint64_t> must be lock-free");
+#endif
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "shm_heightfield: the header layout is shared with other builds");
+
+struct shm_heightfield_slot {
+	std::atomic<uint64_t> sequence;  // even: stable, odd: being written
+	uint64_t generation;             // frame number (1, 2, ...)
+	double time;                     // simulation time of the frame
+	uint64_t padding[5];             // one cache line per slot header
+};
+
+struct shm_heightfield_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t width, height, channels;
+	uint32_t num_slots;
+	uint64_t frame_bytes;
+	uint64_t data_offset;            // from the start of the mapping, 64B aligned
+	float displacement_scale;        // 1/N^2 (the FFT output is unnormalized)
+	uint32_t reserved;
+	std::atomic<uint64_t> latest;    // generation of the last complete frame (0: none yet)
+	shm_heightfield_slot slots[1];   // num_slots entries
+};
+
+// Frame of a slot in the mapping
+inline float const* shm_heightfield_slot_data(shm_heightfield_header const* header, int slot)
+{
+	return reinterpret_cast<float const*>(reinterpret_cast<char const*>(header) + header->data_offset + slot * header->frame_bytes);
+}
+
+struct shm_heightfield_frame {
+	float const* data = nullptr;
+	uint64_t generation = 0;
+	double time = 0.0;
+	int slot = -1;
+	uint64_t sequence = 0;
+};
+
+struct shm_heightfield_reader {
+	shm_heightfield_header const* header = nullptr;
+	size_t mapping_size = 0;
+
+	bool open(std::string const& name);
+	void close();
+
+	bool is_open() const { return header != nullptr; }
+	int width() const { return int(header->width); }
+	int height() const { return int(header->height); }
+
+	// Lock-free access to the latest complete frame (false: nothing published yet)
+	//  Use frame.data in place, then check still_valid(frame) before trusting what was read
+	bool acquire_latest(shm_heightfield_frame& frame) const;
+	bool still_valid(shm_heightfield_frame const& frame) const;
+
+	// Copy of the latest consistent frame into dst (width*height*4 floats), retries on overwrite
+	bool copy_latest(float* dst, shm_heightfield_frame& frame, int max_attempts = 16) const;
+};
@@ -0,0 +1,171 @@
+#include "task_graph.hpp"
+
+#include <algorithm>
+
+// GRAPH
+int task_graph_structure::add_task(std::string const& name, std::function<void()> work)
+{
+	std::unique_ptr<task> t(new task());
+	t->name = name;
+	t->work = std::move(work);
+	tasks.push_back(std::move(t));
+	return int(tasks.size()) - 1;
+}
+
+void task_graph_structure::add_dependency(int before, int after)
+{
+	tasks[before]->successors.push_back(after);
+	tasks[after]->num_dependencies++;
+}
+
+
+// SCHEDULER
+void task_scheduler_structure::initialize(int num_threads_arg)
+{
+	shutdown();
+	num_threads = num_threads_arg > 0 ? num_threads_arg : std::max(1, int(std::thread::hardware_concurrency()));
+
+	stop = false;
+	queues.clear();
+	for (int w = 0; w < num_threads; ++w)
+		queues.emplace_back(new worker_queue());
+	for (int w = 1; w < num_threads; ++w)
+		threads.emplace_back([this, w]() { worker_loop(w); });
+}
+
+void task_scheduler_structure::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex);
+		stop = true;
+	}
+	wake.notify_all();
+	for (auto& t : threads) t.join();
+	threads.clear();
+}
+
+void task_scheduler_structure::push(int worker, int task_id)
+{
+	{
+		std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+		worker_queue& queue = *queues[worker];
+		queue.tasks[queue.tail++] = task_id;
+	}
+	ready.fetch_add(1);
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex); // no lost wake up between the predicate check and the wait
+	}
+	wake.notify_one();
+}
+
+bool task_scheduler_structure::pop_or_steal(int worker, int& task_id)
+{
+	// own queue: newest first (its data is still in cache)
+	{
+		std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+		worker_queue& queue = *queues[worker];
+		if (queue.head < queue.tail) {
+			task_id = queue.tasks[--queue.tail];
+			ready.fetch_sub(1);
+			return true;
+		}
+	}
+	// steal the oldest task of another worker
+	for (int k = 1; k < num_threads; ++k) {
+		worker_queue& victim = *queues[(worker + k) % num_threads];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.head < victim.tail) {
+			task_id = victim.tasks[victim.head++];
+			ready.fetch_sub(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+void task_scheduler_structure::execute(int worker, int task_id)
+{
+	task_graph_structure::task& t = *graph->tasks[task_id];
+
+	auto const start = std::chrono::steady_clock::now();
+	if (t.work) t.work();
+	auto const end = std::chrono::steady_clock::now();
+
+	// barriers are not reported
+	if (t.work) {
+		task_timing timing;
+		timing.name = &t.name;
+		timing.worker = worker;
+		timing.start = std::chrono::duration<double, std::milli>(start - run_start).count();
+		timing.end = std::chrono::duration<double, std::milli>(end - run_start).count();
+		{
+			std::lock_guard<std::mutex> lock(timings_mutex);
+			last_run_timings.push_back(timing);
+		}
+		if (on_task_done) on_task_done(timing);
+	}
+
+	for (int successor : t.successors)
+		if (graph->tasks[successor]->remaining.fetch_sub(1) == 1)
+			push(worker, successor);
+
+	if (remaining.fetch_sub(1) == 1) {
+		{
+			std::lock_guard<std::mutex> lock(wake_mutex);
+		}
+		wake.notify_all(); // graph done: wake the caller
+	}
+}
+
+void task_scheduler_structure::worker_loop(int worker)
+{
+	while (true) {
+		int task_id;
+		if (pop_or_steal(worker, task_id)) {
+			execute(worker, task_id);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(wake_mutex);
+		wake.wait(lock, [this]() { return stop || ready.load() > 0; });
+		if (stop) return;
+	}
+}
+
+void task_scheduler_structure::run(task_graph_structure& graph_arg)
+{
+	if (graph_arg.tasks.empty()) return;
+	if (queues.empty()) initialize(num_threads);
+
+	graph = &graph_arg;
+	last_run_timings.clear();
+	run_start = std::chrono::steady_clock::now();
+	remaining = graph->size();
+	for (auto& t : graph->tasks)
+		t->remaining = t->num_dependencies;
+	for (auto& queue : queues) {
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (int(queue->tasks.size()) < graph->size()) queue->tasks.resize(graph->size()); // only when the graph grows
+		queue->head = queue->tail = 0;
+	}
+
+	// spread the roots over the workers
+	int next_worker = 0;
+	for (int k = 0; k < graph->size(); ++k) {
+		if (graph->tasks[k]->num_dependencies == 0) {
+			push(next_worker, k);
+			next_worker = (next_worker + 1) % num_threads;
+		}
+	}
+
+	// the calling thread is worker 0
+	while (remaining.load() > 0) {
+		int task_id;
+		if (pop_or_steal(0, task_id)) {
+			execute(0, task_id);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(wake_mutex);
+		wake.wait(lock, [this]() { return remaining.load() == 0 || ready.load() > 0; });
+	}
+	graph = nullptr;
+}
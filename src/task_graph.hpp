@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Small work-stealing task graph scheduler (CPU engine)
+//  - a graph is a set of tasks with dependencies, built once per frame
+//  - each worker owns a queue: it pops its newest task, idle workers steal the oldest task of another worker
+//  - a task is queued at most once per run: the queues are sized to the graph and a run does not allocate
+//  - a task becomes ready when all its dependencies are done, on the worker that finished the last one
+//  - the calling thread works too (worker 0) until the whole graph is done
+
+struct task_graph_structure {
+	struct task {
+		std::string name;
+		std::function<void()> work;
+		std::vector<int> successors;
+		int num_dependencies = 0;
+		std::atomic<int> remaining{ 0 };
+	};
+	std::vector<std::unique_ptr<task>> tasks;
+
+	int add_task(std::string const& name, std::function<void()> work);
+	int add_barrier(std::string const& name) { return add_task(name, nullptr); } // joins dependencies, no work
+	void add_dependency(int before, int after);
+	void clear() { tasks.clear(); }
+	int size() const { return int(tasks.size()); }
+};
+
+// Timing of one task of the last run (ms from the start of the run)
+struct task_timing {
+	std::string const* name;
+	int worker;
+	double start, end;
+};
+
+struct task_scheduler_structure {
+	int num_threads = 1; // including the calling thread
+
+	// Called from the worker threads after each task (must be thread safe), e.g. for profiling
+	std::function<void(task_timing const&)> on_task_done;
+	// Timings of the last run, in completion order
+	std::vector<task_timing> last_run_timings;
+
+	void initialize(int num_threads_arg = 0); // 0: hardware concurrency
+	void run(task_graph_structure& graph);    // blocks until every task of the graph is done
+	void shutdown();
+	~task_scheduler_structure() { shutdown(); }
+
+	// internal state
+	struct worker_queue {
+		std::mutex mutex;
+		std::vector<int> tasks; // [head, tail) queued, reset at each run
+		int head = 0, tail = 0;
+	};
+	std::vector<std::unique_ptr<worker_queue>> queues;
+	std::vector<std::thread> threads;
+
+	std::mutex wake_mutex;
+	std::condition_variable wake;
+	std::atomic<int> ready{ 0 };      // tasks in the queues
+	std::atomic<int> remaining{ 0 };  // tasks of the current graph not done yet
+	std::atomic<bool> stop{ false };
+	task_graph_structure* graph = nullptr;
+
+	std::mutex timings_mutex;
+	std::chrono::steady_clock::time_point run_start;
+
+	void push(int worker, int task_id);
+	bool pop_or_steal(int worker, int& task_id);
+	void execute(int worker, int task_id);
+	void worker_loop(int worker);
+};
@@ -0,0 +1,100 @@
+#include "temporal_lod.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const float g = 9.81f;             // gravity
+static const float PI_F = 3.14159265359f;
+
+void temporal_lod_structure::initialize(std::vector<temporal_lod_band> const& bands_arg)
+{
+	bands = bands_arg;
+	time_prev = time_next = 0.0;
+	frames_left = 0;
+	active_band = 0;
+	invalidated = true;
+	// budget control: no load history carried over, the hysteresis starts again from the new bands
+	frame_time_average = 0.f;
+	load_average = 0.f;
+	frames_over = frames_under = 0;
+	pressure = 0;
+}
+
+int temporal_lod_structure::band_of(float distance) const
+{
+	int band = 0;
+	for (int b = 0; b < int(bands.size()); ++b)
+		if (distance >= bands[b].distance) band = b;
+	return band;
+}
+
+int temporal_lod_structure::max_period(int band, float dt) const
+{
+	// linear interpolation of A*cos(w t) over T: max error = A*(1 - cos(w T/2)) ~ A*(w T)^2/8
+	float const omega = std::sqrt(g * bands[band].k_visible);
+	if (omega <= 0.f || dt <= 0.f) return TEMPORAL_LOD_MAX_PERIOD;
+	float const T = std::sqrt(8.f * error_tolerance) / omega;
+	return std::max(1, std::min(TEMPORAL_LOD_MAX_PERIOD, int(T / dt)));
+}
+
+int temporal_lod_structure::period(int band, float dt) const
+{
+	if (!enabled || bands.empty()) return 1;
+	int const p = bands[band].base_period + pressure;
+	return std::max(1, std::min(p, max_period(band, dt)));
+}
+
+bool temporal_lod_structure::begin_frame(double time, float dt, float distance)
+{
+	active_band = bands.empty() ? 0 : band_of(distance);
+	// no valid previous keyframe after an invalidation: simulate the current time only
+	int const p = invalidated ? 1 : period(active_band, dt);
+
+	// keep interpolating, unless the camera moved to a band needing a shorter period
+	if (!invalidated && frames_left > 0 && frames_left < p) {
+		--frames_left;
+		return false;
+	}
+
+	time_prev = invalidated ? time : time_next;
+	time_next = time + (p - 1) * dt; // period 1: simulate the current time (no interpolation)
+	frames_left = p - 1;
+	invalidated = false;
+	return true;
+}
+
+float temporal_lod_structure::blend(double time) const
+{
+	if (time_next <= time_prev) return 1.f;
+	return std::max(0.f, std::min(1.f, float((time - time_prev) / (time_next - time_prev))));
+}
+
+void temporal_lod_structure::end_frame(float frame_time, float load)
+{
+	frame_time_average = frame_time_average == 0.f ? frame_time : 0.9f * frame_time_average + 0.1f * frame_time;
+	load_average = load_average == 0.f ? load : 0.9f * load_average + 0.1f * load;
+
+	// with vsync the frame time never drops under the budget: headroom is measured on the load
+	float const high = frame_budget * (1.f + hysteresis), low = frame_budget * (1.f - hysteresis);
+	frames_over = (frame_time_average > high || load_average > high) ? frames_over + 1 : 0;
+	frames_under = (load_average < low && frame_time_average < high) ? frames_under + 1 : 0;
+	if (!adaptive) return;
+
+	// pressure is bounded so that it always changes at least one band period
+	int const base_max = bands.empty() ? 1 : bands.back().base_period;
+	if (frames_over >= hysteresis_frames && pressure < TEMPORAL_LOD_MAX_PERIOD) {
+		++pressure;
+		frames_over = 0;
+	}
+	if (frames_under >= hysteresis_frames && pressure > 1 - base_max) {
+		--pressure;
+		frames_under = 0;
+	}
+}
+
+float temporal_lod_visible_wave_number(float distance, float pixel_angle, float world_to_simulation, float k_max, float pixels_per_wave)
+{
+	float const wavelength = pixels_per_wave * distance * pixel_angle * world_to_simulation;
+	if (wavelength <= 0.f) return k_max;
+	return std::min(k_max, 2.f * PI_F / wavelength);
+}
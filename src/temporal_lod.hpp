@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+
+// Temporal level of detail: the ocean is simulated only every `period` frames (keyframes)
+//  and the rendered maps are interpolated between the two last keyframes.
+//  - each band is a camera distance range; far from the water only long waves are visible, so keyframes can be sparser
+//  - the period of a band never exceeds the one keeping the interpolation error under error_tolerance
+//  - within that bound, periods grow/shrink with the measured load (with hysteresis); the frame time alone is pinned by vsync
+
+#define TEMPORAL_LOD_MAX_PERIOD 16
+
+struct temporal_lod_band {
+	float distance = 0.f;   // camera distance to the water from which the band is used
+	float k_visible = 0.f;  // largest wave number (simulation units) visible from that distance
+	int base_period = 1;    // period at zero pressure
+};
+
+struct temporal_lod_structure {
+	std::vector<temporal_lod_band> bands;
+
+	bool enabled = true;
+	bool adaptive = true;              // false: pressure is set from outside (quality governor)
+	float error_tolerance = 0.02f;     // max interpolation error, relative to the wave amplitude
+	float frame_budget = 1.f / 60.f;   // target frame time (s)
+	float hysteresis = 0.15f;          // relative margin around the budget before acting
+	int hysteresis_frames = 30;        // consecutive frames outside the margin before acting
+
+	// keyframes (double: the simulation clock runs for days)
+	double time_prev = 0.0, time_next = 0.0;
+	int frames_left = 0;
+	int active_band = 0;
+	bool invalidated = true;
+
+	// budget control
+	float frame_time_average = 0.f;
+	float load_average = 0.f;          // max(CPU work, GPU work) of the frame, without the wait for vsync
+	int frames_over = 0, frames_under = 0;
+	int pressure = 0;
+
+	// Bands must be sorted by increasing distance
+	void initialize(std::vector<temporal_lod_band> const& bands_arg);
+
+	int band_of(float distance) const;
+	int max_period(int band, float dt) const; // bound from the error tolerance
+	int period(int band, float dt) const;     // current period of the band
+
+	// Returns true if a keyframe must be simulated this frame, at time keyframe_time()
+	bool begin_frame(double time, float dt, float distance);
+	double keyframe_time() const { return time_next; }
+	// The keyframe was simulated at a slightly different time (CPU engine: spectrum computed ahead)
+	void set_keyframe_time(double time) { time_next = time; }
+	// Interpolation factor between the previous and the new keyframe (1 = new keyframe)
+	float blend(double time) const;
+	// Adapt the periods to the measured frame time and load (s): over budget if either is, under budget only on the load
+	void end_frame(float frame_time, float load);
+
+	// Force a keyframe on the next frame (e.g. the initial spectrum changed)
+	void invalidate() { invalidated = true; }
+};
+
+// Largest wave number (simulation units) still covering `pixels_per_wave` pixels at a given distance
+float temporal_lod_visible_wave_number(float distance, float pixel_angle, float world_to_simulation, float k_max, float pixels_per_wave = 4.f);